@@ -17,6 +17,7 @@
 #pragma once
 
 #include <functional>
+#include <stdexcept>
 
 #include "accelerator/Range.h"
 #include "flatbuffers/flatbuffers.h"
@@ -71,10 +72,45 @@ class Builder {
     return std::move(data_);
   }
 
+  // Align numeric array payloads written afterwards by setItemValue() and
+  // by the row and column setters of the matrix builders, e.g. 32 for AVX2
+  // or 64 for AVX-512. 0 keeps the default element-size alignment.
+  size_t getVectorAlignment() const {
+    return vectorAlignment_;
+  }
+  void setVectorAlignment(size_t alignment) {
+    vectorAlignment_ = alignment;
+  }
+
+  // Bytes of overwritten cells which are still held in the FBB and would
+  // end up in the finished buffer as dead space. It counts the bytes
+  // written for each replaced cell, shared vtables included, so it is an
+  // upper bound of what compaction saves.
+  size_t deadBytes() const {
+    return deadBytes_;
+  }
+
+  // Let finish() re-emit only the reachable cells into a fresh buffer when
+  // there are dead bytes, instead of finishing the FBB in place. Only for
+  // an owned FBB, a shared one is finished by its owner and has to keep
+  // what was written into it.
+  bool getCompact() const {
+    return compact_;
+  }
+  void setCompact(bool compact) {
+    if (compact && !owns_) {
+      throw std::invalid_argument("compaction needs an owned FBB");
+    }
+    compact_ = compact;
+  }
+
  protected:
   std::unique_ptr<FBB> fbb_;
   bool owns_{true};
   bool finished_{false};
+  size_t vectorAlignment_{0};
+  size_t deadBytes_{0};
+  bool compact_{false};
 
   ::flatbuffers::DetachedBuffer data_;
 };
@@ -61,4 +61,41 @@ copy(::flatbuffers::FlatBufferBuilder& fbb, fbs::Any type, const void* obj) {
   return ::flatbuffers::Offset<void>();
 }
 
+::flatbuffers::Offset<void>
+copyAligned(::flatbuffers::FlatBufferBuilder& fbb,
+            fbs::Any type,
+            const void* obj,
+            size_t alignment) {
+  size_t elemsize = 0;
+  size_t len = 0;
+  switch (type) {
+#define FTT_ANY_COPY_ALIGNED_CASE(t, ft) \
+    case fbs::Any::ft##Array: \
+      elemsize = sizeof(t); \
+      len = reinterpret_cast<const fbs::ft##Array*>(obj)->value()->size(); \
+      break;
+
+    FTT_ANY_COPY_ALIGNED_CASE(int8_t,   Int8)
+    FTT_ANY_COPY_ALIGNED_CASE(int16_t,  Int16)
+    FTT_ANY_COPY_ALIGNED_CASE(int32_t,  Int32)
+    FTT_ANY_COPY_ALIGNED_CASE(int64_t,  Int64)
+    FTT_ANY_COPY_ALIGNED_CASE(uint8_t,  UInt8)
+    FTT_ANY_COPY_ALIGNED_CASE(uint16_t, UInt16)
+    FTT_ANY_COPY_ALIGNED_CASE(uint32_t, UInt32)
+    FTT_ANY_COPY_ALIGNED_CASE(uint64_t, UInt64)
+    FTT_ANY_COPY_ALIGNED_CASE(float,    Float)
+    FTT_ANY_COPY_ALIGNED_CASE(double,   Double)
+
+#undef FTT_ANY_COPY_ALIGNED_CASE
+
+    default:
+      break;
+  }
+  // the array payload is the first thing copy() writes
+  if (alignment > elemsize && elemsize > 0) {
+    fbb.ForceVectorAlignment(len, elemsize, alignment);
+  }
+  return copy(fbb, type, obj);
+}
+
 } // namespace ftt
@@ -88,6 +88,14 @@ copy(::flatbuffers::FlatBufferBuilder& fbb, const fbs::StringArray& obj) {
 ::flatbuffers::Offset<void>
 copy(::flatbuffers::FlatBufferBuilder& fbb, fbs::Any type, const void* obj);
 
+// Same as copy(), numeric array payloads are aligned to alignment bytes
+// as encodeAligned() does.
+::flatbuffers::Offset<void>
+copyAligned(::flatbuffers::FlatBufferBuilder& fbb,
+            fbs::Any type,
+            const void* obj,
+            size_t alignment);
+
 // Tuple
 inline ::flatbuffers::Offset<fbs::Tuple>
 copy(::flatbuffers::FlatBufferBuilder& fbb, const fbs::Tuple& obj) {
@@ -173,6 +173,65 @@ FTT_BASE_DECODE_ARRAY(double,   Double)
 #undef FTT_BASE_ENCODE_ARRAY
 #undef FTT_BASE_DECODE_ARRAY
 
+// aligned numeric array encoding
+//
+// The payload is aligned to `alignment` bytes relative to the end of the
+// buffer, so it is absolutely aligned whenever the finished buffer is (e.g.
+// mmapped or copied into aligned memory), check it with isAligned().
+#define FTT_BASE_ENCODE_ALIGNED_ARRAY(t, ft) \
+inline ::flatbuffers::Offset<fbs::ft##Array> \
+encodeAligned(::flatbuffers::FlatBufferBuilder& fbb, \
+              const std::vector<t>& value, \
+              size_t alignment) { \
+  if (alignment > sizeof(t)) { \
+    fbb.ForceVectorAlignment(value.size(), sizeof(t), alignment); \
+  } \
+  return fbs::Create##ft##Array(fbb, fbb.CreateVector(value)); \
+}
+
+FTT_BASE_ENCODE_ALIGNED_ARRAY(int8_t,   Int8)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(int16_t,  Int16)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(int32_t,  Int32)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(int64_t,  Int64)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(uint8_t,  UInt8)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(uint16_t, UInt16)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(uint32_t, UInt32)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(uint64_t, UInt64)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(float,    Float)
+FTT_BASE_ENCODE_ALIGNED_ARRAY(double,   Double)
+
+#undef FTT_BASE_ENCODE_ALIGNED_ARRAY
+
+// other types have nothing to align
+template <class T>
+inline auto
+encodeAligned(::flatbuffers::FlatBufferBuilder& fbb,
+              const T& value,
+              size_t) -> decltype(encode(fbb, value)) {
+  return encode(fbb, value);
+}
+
+#define FTT_BASE_DECODE_ARRAY_VIEW(t, ft) \
+inline void \
+decode(const void* ptr, acc::Range<const t*>& value) { \
+  auto p = reinterpret_cast<const fbs::ft##Array*>(ptr); \
+  value.reset(p->value()->data(), p->value()->size()); \
+}
+
+// numeric array decoding (no copy)
+FTT_BASE_DECODE_ARRAY_VIEW(int8_t,   Int8)
+FTT_BASE_DECODE_ARRAY_VIEW(int16_t,  Int16)
+FTT_BASE_DECODE_ARRAY_VIEW(int32_t,  Int32)
+FTT_BASE_DECODE_ARRAY_VIEW(int64_t,  Int64)
+FTT_BASE_DECODE_ARRAY_VIEW(uint8_t,  UInt8)
+FTT_BASE_DECODE_ARRAY_VIEW(uint16_t, UInt16)
+FTT_BASE_DECODE_ARRAY_VIEW(uint32_t, UInt32)
+FTT_BASE_DECODE_ARRAY_VIEW(uint64_t, UInt64)
+FTT_BASE_DECODE_ARRAY_VIEW(float,    Float)
+FTT_BASE_DECODE_ARRAY_VIEW(double,   Double)
+
+#undef FTT_BASE_DECODE_ARRAY_VIEW
+
 // vector<bool> encoding
 inline ::flatbuffers::Offset<fbs::BoolArray>
 encode(::flatbuffers::FlatBufferBuilder& fbb, const std::vector<bool>& value) {
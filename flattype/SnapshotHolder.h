@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ftt {
+
+namespace detail {
+
+// the counter stripe of the calling thread
+inline size_t snapshotReaderStripe() {
+  static std::atomic<size_t> next{0};
+  static thread_local size_t stripe = next.fetch_add(1);
+  return stripe;
+}
+
+} // namespace detail
+
+/*
+ * Holds the current snapshot of a reloaded object, e.g. an Index or a
+ * Bucket, for concurrent readers without locks (an RCU scheme).
+ *
+ * read() is wait-free: it bumps a reader counter of the current epoch,
+ * striped over cache lines by thread, and loads the pointer. publish()
+ * swaps in a new object, then waits for a grace period of two epoch
+ * flips, after which no reader can hold the old object, and destroys it.
+ * Readers should not keep a ReadGuard longer than a request, as it holds
+ * back the reclamation and so the publisher.
+ */
+template <class T>
+class SnapshotHolder {
+ public:
+  class ReadGuard {
+   public:
+    ReadGuard(ReadGuard&& other)
+      : counter_(other.counter_),
+        ptr_(other.ptr_) {
+      other.counter_ = nullptr;
+    }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ReadGuard& operator=(ReadGuard&&) = delete;
+
+    ~ReadGuard() {
+      if (counter_) {
+        counter_->fetch_sub(1);
+      }
+    }
+
+    explicit operator bool() const {
+      return ptr_ != nullptr;
+    }
+    const T* get() const {
+      return ptr_;
+    }
+    const T* operator->() const {
+      return ptr_;
+    }
+    const T& operator*() const {
+      return *ptr_;
+    }
+
+   private:
+    friend class SnapshotHolder;
+
+    ReadGuard(std::atomic<int64_t>* counter, const T* ptr)
+      : counter_(counter),
+        ptr_(ptr) {}
+
+    std::atomic<int64_t>* counter_;
+    const T* ptr_;
+  };
+
+  SnapshotHolder() {}
+  explicit SnapshotHolder(std::unique_ptr<T> value)
+    : current_(value.release()) {}
+
+  // no reader may be left
+  ~SnapshotHolder() {
+    delete current_.load();
+  }
+
+  SnapshotHolder(const SnapshotHolder&) = delete;
+  SnapshotHolder& operator=(const SnapshotHolder&) = delete;
+
+  ReadGuard read() const {
+    auto& counter = counters_[epoch_.load() & 1][
+        detail::snapshotReaderStripe() % kStripes].n;
+    counter.fetch_add(1);
+    return ReadGuard(&counter, current_.load());
+  }
+
+  // replace the snapshot, returns once the old one is destroyed
+  void publish(std::unique_ptr<T> value) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::unique_ptr<T> old(current_.exchange(value.release()));
+    // a reader of old counted itself before the exchange, in one of the
+    // two parities, so it is waited for in one of the two flips
+    for (int i = 0; i < 2; i++) {
+      size_t parity = epoch_.fetch_add(1) & 1;
+      while (readers(parity) != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  enum : size_t {
+    kStripes = 32,
+  };
+
+  struct alignas(64) Counter {
+    std::atomic<int64_t> n{0};
+  };
+
+  int64_t readers(size_t parity) const {
+    int64_t n = 0;
+    for (size_t i = 0; i < kStripes; i++) {
+      n += counters_[parity][i].n.load();
+    }
+    return n;
+  }
+
+  std::atomic<T*> current_{nullptr};
+  std::atomic<size_t> epoch_{0};
+  mutable Counter counters_[2][kStripes];
+  std::mutex mutex_;
+};
+
+} // namespace ftt
@@ -19,7 +19,7 @@
 
 namespace ftt {
 
-std::string Tuple::toDebugString() const {
+std::string TupleRef::toDebugString() const {
   std::string out;
   if (!get()) {
     return "{}";
@@ -18,11 +18,39 @@
 
 #include "flattype/CommonIDLs.h"
 #include "flattype/Encoding.h"
+#include "flattype/TupleView.h"
 #include "flattype/Util.h"
 #include "flattype/Wrapper.h"
 
 namespace ftt {
 
+class TupleRef : public Ref<fbs::Tuple> {
+ public:
+  TupleRef() {}
+  TupleRef(const fbs::Tuple* tuple) : Ref(tuple) {}
+
+  std::string toDebugString() const;
+
+  size_t getCount() const;
+
+  const void* getItem(size_t i) const;
+
+  template <class... Args>
+  bool getValue(Args&... args) const;
+  template <class T>
+  bool getItemValue(size_t i, T& value) const;
+
+  fbs::Any getItemType(size_t i) const;
+
+  // checked once, see TupleView
+  template <class... Args>
+  TupleView<Args...> getView() const;
+};
+
+static_assert(sizeof(TupleRef) == sizeof(void*) &&
+              std::is_trivially_copyable<TupleRef>::value,
+              "TupleRef must stay a trivially copyable pointer");
+
 class Tuple : public Wrapper<fbs::Tuple> {
  public:
   Tuple(const fbs::Tuple* tuple) : Wrapper(tuple) {}
@@ -38,42 +66,61 @@ class Tuple : public Wrapper<fbs::Tuple> {
   Tuple(Tuple&&) = default;
   Tuple& operator=(Tuple&&) = default;
 
-  std::string toDebugString() const override;
+  TupleRef ref() const { return TupleRef(ptr_); }
 
-  size_t getCount() const;
+  std::string toDebugString() const override {
+    return ref().toDebugString();
+  }
 
-  const void* getItem(size_t i) const;
+  size_t getCount() const {
+    return ref().getCount();
+  }
+
+  const void* getItem(size_t i) const {
+    return ref().getItem(i);
+  }
 
   template <class... Args>
-  bool getValue(Args&... args) const;
+  bool getValue(Args&... args) const {
+    return ref().getValue(args...);
+  }
   template <class T>
-  bool getItemValue(size_t i, T& value) const;
+  bool getItemValue(size_t i, T& value) const {
+    return ref().getItemValue(i, value);
+  }
 
-  fbs::Any getItemType(size_t i) const;
+  fbs::Any getItemType(size_t i) const {
+    return ref().getItemType(i);
+  }
+
+  template <class... Args>
+  TupleView<Args...> getView() const {
+    return ref().getView<Args...>();
+  }
 };
 
 //////////////////////////////////////////////////////////////////////
 
 inline size_t
-Tuple::getCount() const {
+TupleRef::getCount() const {
   return ftt::size(ptr_);
 }
 
 inline const void*
-Tuple::getItem(size_t i) const {
+TupleRef::getItem(size_t i) const {
   return i < ftt::size(ptr_) ? ftt::at(ptr_, i) : nullptr;
 }
 
 template <class... Args>
 inline bool
-Tuple::getValue(Args&... args) const {
+TupleRef::getValue(Args&... args) const {
   decode(ptr_, args...);
   return true;
 }
 
 template <class T>
 inline bool
-Tuple::getItemValue(size_t i, T& value) const {
+TupleRef::getItemValue(size_t i, T& value) const {
   auto item = getItem(i);
   if (item) {
     decode(item, value);
@@ -83,8 +130,14 @@ Tuple::getItemValue(size_t i, T& value) const {
 }
 
 inline fbs::Any
-Tuple::getItemType(size_t i) const {
+TupleRef::getItemType(size_t i) const {
   return i < ftt::size(ptr_) ? decodeOneType(ptr_, i) : fbs::Any::NONE;
 }
 
+template <class... Args>
+inline TupleView<Args...>
+TupleRef::getView() const {
+  return TupleView<Args...>(ptr_);
+}
+
 } // namespace ftt
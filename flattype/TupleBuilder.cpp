@@ -22,8 +22,23 @@ void TupleBuilder::finish() {
   if (finished_) {
     return;
   }
-  fbb_->Finish(fbs::CreateTupleDirect(*fbb_, &types_, &items_));
-  data_ = fbb_->Release();
+  if (compact_ && deadBytes_ > 0) {
+    FBB fbb;
+    std::vector<flatbuffers::Offset<void>> items;
+    for (size_t i = 0; i < items_.size(); i++) {
+      items.push_back(items_[i].IsNull()
+                      ? items_[i]
+                      : copyAligned(fbb,
+                                    acc::to<fbs::Any>(types_[i]),
+                                    getItem(i),
+                                    vectorAlignment_));
+    }
+    fbb.Finish(fbs::CreateTupleDirect(fbb, &types_, &items));
+    data_ = fbb.Release();
+  } else {
+    fbb_->Finish(fbs::CreateTupleDirect(*fbb_, &types_, &items_));
+    data_ = fbb_->Release();
+  }
   finished_ = true;
 }
 
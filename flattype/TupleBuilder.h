@@ -59,9 +59,13 @@ class TupleBuilder : public Builder {
 
  private:
   void resize(size_t i);
+  void retire(size_t i, size_t mark);
+  void appended(size_t n, size_t mark);
 
   std::vector<uint8_t> types_;
   std::vector<flatbuffers::Offset<void>> items_;
+  // bytes written for each item, counted as dead once overwritten
+  std::vector<uint32_t> sizes_;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -70,6 +74,21 @@ inline void TupleBuilder::resize(size_t i) {
   if (i >= items_.size()) {
     types_.resize(i + 1);
     items_.resize(i + 1);
+    sizes_.resize(i + 1);
+  }
+}
+
+// item i was rewritten with the bytes written since mark
+inline void TupleBuilder::retire(size_t i, size_t mark) {
+  deadBytes_ += sizes_[i];
+  sizes_[i] = fbb_->GetSize() - mark;
+}
+
+// items from n on were appended since mark, one after another
+inline void TupleBuilder::appended(size_t n, size_t mark) {
+  for (size_t i = n; i < items_.size(); i++) {
+    sizes_.push_back(items_[i].o - mark);
+    mark = items_[i].o;
   }
 }
 
@@ -90,8 +109,10 @@ inline void
 TupleBuilder::setItem(size_t i, fbs::Any type, const void* item) {
   assert(item != nullptr);
   resize(i);
+  size_t mark = fbb_->GetSize();
   types_[i] = acc::to<uint8_t>(type);
   items_[i] = copy(*fbb_, type, item);
+  retire(i, mark);
 }
 
 template <class... Args>
@@ -104,7 +125,10 @@ TupleBuilder::getValue(Args&... args) const {
 template <class... Args>
 inline bool
 TupleBuilder::setValue(const Args&... args) {
+  size_t n = items_.size();
+  size_t mark = fbb_->GetSize();
   detail::vencodeImpl(*fbb_, types_, items_, args...);
+  appended(n, mark);
   return true;
 }
 
@@ -123,8 +147,10 @@ template <class T>
 inline bool
 TupleBuilder::setItemValue(size_t i, const T& value) {
   resize(i);
-  types_[i] = getAnyType<T>();
-  items_[i] = encode(*fbb_, value).Union();
+  size_t mark = fbb_->GetSize();
+  types_[i] = acc::to<uint8_t>(getAnyType<T>());
+  items_[i] = encodeAligned(*fbb_, value, vectorAlignment_).Union();
+  retire(i, mark);
   return true;
 }
 
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "accelerator/Range.h"
+#include "flattype/CommonIDLs.h"
+#include "flattype/Encoding.h"
+#include "flattype/Type.h"
+
+namespace ftt {
+
+namespace detail {
+
+// the no-copy type get<I>() returns for a tuple element declared as T
+
+template <class T, class Enable = void>
+struct TupleViewElement {
+  typedef const typename AnyType<T>::type* type;
+
+  static type get(const void* ptr) {
+    return reinterpret_cast<type>(ptr);
+  }
+};
+
+template <class T>
+struct TupleViewElement<T,
+  typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+  typedef T type;
+
+  static type get(const void* ptr) {
+    return reinterpret_cast<const typename AnyType<T>::type*>(ptr)->value();
+  }
+};
+
+template <class T>
+struct TupleViewElement<T,
+  typename std::enable_if<
+    std::is_convertible<T, acc::StringPiece>::value>::type> {
+  typedef acc::StringPiece type;
+
+  static type get(const void* ptr) {
+    auto s = reinterpret_cast<const fbs::String*>(ptr)->value();
+    return acc::StringPiece(s->data(), s->size());
+  }
+};
+
+template <class T>
+struct TupleViewElement<std::vector<T>,
+  typename std::enable_if<
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type> {
+  typedef acc::Range<const T*> type;
+
+  static type get(const void* ptr) {
+    type value;
+    decode(ptr, value);
+    return value;
+  }
+};
+
+template <class T>
+struct TupleViewElement<acc::Range<const T*>,
+  typename std::enable_if<
+    std::is_arithmetic<T>::value &&
+    !std::is_convertible<acc::Range<const T*>, acc::StringPiece>::value
+  >::type> {
+  typedef acc::Range<const T*> type;
+
+  static type get(const void* ptr) {
+    type value;
+    decode(ptr, value);
+    return value;
+  }
+};
+
+} // namespace detail
+
+/*
+ * A tuple whose element types are checked once against Args..., with one
+ * memcmp of its value_type vector. Afterwards get<I>() reads element I
+ * without any type check or copy: scalars by value, strings as StringPiece,
+ * numeric arrays as acc::Range, other types as their fbs table pointers.
+ *
+ * A view failing the check is empty (operator bool is false). The view is
+ * a single pointer and trivially copyable.
+ */
+template <class... Args>
+class TupleView {
+ public:
+  static_assert(sizeof...(Args) > 0, "TupleView of an empty tuple");
+
+  static constexpr size_t kSize = sizeof...(Args);
+  static constexpr uint8_t kSignature[sizeof...(Args)] = {
+    static_cast<uint8_t>(fbs::AnyTraits<typename AnyType<Args>::type>::enum_value)...
+  };
+
+  template <size_t I>
+  using element_type = typename detail::TupleViewElement<
+    typename std::tuple_element<I, std::tuple<Args...>>::type>::type;
+
+  static bool check(const fbs::Tuple* tuple) {
+    if (!tuple || !tuple->value_type() || !tuple->value()) {
+      return false;
+    }
+    auto types = tuple->value_type();
+    return types->size() == kSize &&
+      tuple->value()->size() == kSize &&
+      memcmp(types->data(), kSignature, kSize) == 0;
+  }
+
+  TupleView() {}
+  explicit TupleView(const fbs::Tuple* tuple)
+    : ptr_(check(tuple) ? tuple : nullptr) {}
+
+  explicit operator bool() const {
+    return ptr_ != nullptr;
+  }
+  const fbs::Tuple* get() const {
+    return ptr_;
+  }
+
+  template <size_t I>
+  element_type<I> get() const {
+    static_assert(I < kSize, "TupleView index out of range");
+    return detail::TupleViewElement<
+      typename std::tuple_element<I, std::tuple<Args...>>::type
+    >::get(ptr_->value()->Get(I));
+  }
+
+ private:
+  const fbs::Tuple* ptr_{nullptr};
+};
+
+template <class... Args>
+constexpr size_t TupleView<Args...>::kSize;
+
+template <class... Args>
+constexpr uint8_t TupleView<Args...>::kSignature[sizeof...(Args)];
+
+} // namespace ftt
@@ -62,6 +62,16 @@ FTT_ANY_TYPE(std::vector<uint32_t>, UInt32Array)
 FTT_ANY_TYPE(std::vector<uint64_t>, UInt64Array)
 FTT_ANY_TYPE(std::vector<float>,    FloatArray)
 FTT_ANY_TYPE(std::vector<double>,   DoubleArray)
+FTT_ANY_TYPE(acc::Range<const int8_t*>,   Int8Array)
+FTT_ANY_TYPE(acc::Range<const int16_t*>,  Int16Array)
+FTT_ANY_TYPE(acc::Range<const int32_t*>,  Int32Array)
+FTT_ANY_TYPE(acc::Range<const int64_t*>,  Int64Array)
+FTT_ANY_TYPE(acc::Range<const uint8_t*>,  UInt8Array)
+FTT_ANY_TYPE(acc::Range<const uint16_t*>, UInt16Array)
+FTT_ANY_TYPE(acc::Range<const uint32_t*>, UInt32Array)
+FTT_ANY_TYPE(acc::Range<const uint64_t*>, UInt64Array)
+FTT_ANY_TYPE(acc::Range<const float*>,    FloatArray)
+FTT_ANY_TYPE(acc::Range<const double*>,   DoubleArray)
 
 #undef FTT_ANY_TYPE
 
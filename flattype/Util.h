@@ -111,6 +111,13 @@ findConst(const ::flatbuffers::Vector<T>* vector, const K& key) {
 
 //////////////////////////////////////////////////////////////////////
 
+// hint a read of p soon, e.g. while resolving a batch of lookups
+inline void prefetch(const void* p) {
+  __builtin_prefetch(p);
+}
+
+//////////////////////////////////////////////////////////////////////
+
 template <class FT>
 inline size_t size(const FT* array) {
   return array->value()->size();
@@ -136,6 +143,25 @@ inline auto end(const FT* array)
 
 //////////////////////////////////////////////////////////////////////
 
+// alignment check for SIMD loads on the raw buffer
+
+inline bool isAligned(const void* ptr, size_t alignment) {
+  return (reinterpret_cast<uintptr_t>(ptr) & (alignment - 1)) == 0;
+}
+
+template <class T>
+inline bool isAligned(const ::flatbuffers::Vector<T>* vector,
+                      size_t alignment) {
+  return isAligned(vector->data(), alignment);
+}
+
+template <class T>
+inline bool isAligned(acc::Range<const T*> range, size_t alignment) {
+  return isAligned(range.data(), alignment);
+}
+
+//////////////////////////////////////////////////////////////////////
+
 inline acc::StringPiece stringPiece(const ::flatbuffers::String* s) {
   return acc::StringPiece(s->data(), s->size());
 }
@@ -16,11 +16,45 @@
 
 #pragma once
 
+#include <type_traits>
+
 #include "accelerator/Range.h"
 #include "flatbuffers/flatbuffers.h"
 
 namespace ftt {
 
+/*
+ * Non-owning view of a flatbuffers table: a single pointer, trivially
+ * copyable and without virtual functions, cheap enough to create per row.
+ * Each Ref type static_asserts that it keeps this layout.
+ */
+template <class FT>
+class Ref {
+ public:
+  Ref() {}
+  Ref(const FT* ptr) : ptr_(ptr) {}
+
+  explicit operator bool() const {
+    return ptr_ != nullptr;
+  }
+  const FT* get() const {
+    return ptr_;
+  }
+  const FT* operator->() const {
+    return ptr_;
+  }
+  const FT& operator*() const {
+    return *ptr_;
+  }
+
+ protected:
+  const FT* ptr_{nullptr};
+};
+
+/*
+ * Owning counterpart of Ref, holds the buffer when built from one. The
+ * read API of each wrapper forwards to its Ref type.
+ */
 template <class FT>
 class Wrapper {
  public:
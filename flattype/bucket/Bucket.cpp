@@ -22,7 +22,7 @@
 
 namespace ftt {
 
-std::string Bucket::toDebugString() const {
+std::string BucketRef::toDebugString() const {
   std::string out;
   if (!get()) {
     return "{}";
@@ -31,22 +31,22 @@ std::string Bucket::toDebugString() const {
                 ", bid:", getBID(),
                 ", fields:", acc::join(',', getFields()),
                 ", matrix:", isColumnar()
-                              ? ColumnarMatrix(getMatrix()).toDebugString()
-                              : Matrix(getMatrix()).toDebugString(),
+                              ? ColumnarMatrixRef(getMatrix()).toDebugString()
+                              : MatrixRef(getMatrix()).toDebugString(),
                 " }",
                 &out);
   return out;
 }
 
-uint16_t Bucket::getBID() const {
+uint16_t BucketRef::getBID() const {
   return ptr_ ? ptr_->bid() : 0;
 }
 
-std::string Bucket::getName() const {
+std::string BucketRef::getName() const {
   return ptr_ ? ptr_->name()->str() : "";
 }
 
-std::vector<std::string> Bucket::getFields() const {
+std::vector<std::string> BucketRef::getFields() const {
   std::vector<std::string> fields;
   if (ptr_ && ptr_->fields()) {
     for (auto i : *ptr_->fields()) {
@@ -56,11 +56,11 @@ std::vector<std::string> Bucket::getFields() const {
   return fields;
 }
 
-const fbs::Matrix* Bucket::getMatrix() const {
+const fbs::Matrix* BucketRef::getMatrix() const {
   return ptr_ ? ptr_->matrix() : nullptr;
 }
 
-bool Bucket::isColumnar() const {
+bool BucketRef::isColumnar() const {
   return ptr_ ? ptr_->columnar() : false;
 }
 
@@ -21,6 +21,24 @@
 
 namespace ftt {
 
+class BucketRef : public Ref<fbs::Bucket> {
+ public:
+  BucketRef() {}
+  BucketRef(const fbs::Bucket* bucket) : Ref(bucket) {}
+
+  std::string toDebugString() const;
+
+  uint16_t getBID() const;
+  std::string getName() const;
+  std::vector<std::string> getFields() const;
+  const fbs::Matrix* getMatrix() const;
+  bool isColumnar() const;
+};
+
+static_assert(sizeof(BucketRef) == sizeof(void*) &&
+              std::is_trivially_copyable<BucketRef>::value,
+              "BucketRef must stay a trivially copyable pointer");
+
 class Bucket : public Wrapper<fbs::Bucket> {
  public:
   Bucket(const fbs::Bucket* bucket) : Wrapper(bucket) {}
@@ -36,13 +54,27 @@ class Bucket : public Wrapper<fbs::Bucket> {
   Bucket(Bucket&&) = default;
   Bucket& operator=(Bucket&&) = default;
 
-  std::string toDebugString() const override;
+  BucketRef ref() const { return BucketRef(ptr_); }
 
-  uint16_t getBID() const;
-  std::string getName() const;
-  std::vector<std::string> getFields() const;
-  const fbs::Matrix* getMatrix() const;
-  bool isColumnar() const;
+  std::string toDebugString() const override {
+    return ref().toDebugString();
+  }
+
+  uint16_t getBID() const {
+    return ref().getBID();
+  }
+  std::string getName() const {
+    return ref().getName();
+  }
+  std::vector<std::string> getFields() const {
+    return ref().getFields();
+  }
+  const fbs::Matrix* getMatrix() const {
+    return ref().getMatrix();
+  }
+  bool isColumnar() const {
+    return ref().isColumnar();
+  }
 };
 
 } // namespace ftt
@@ -0,0 +1,341 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "accelerator/Range.h"
+#include "flattype/CommonIDLs.h"
+#include "flattype/Util.h"
+#include "flattype/hash/Hash.h"
+#include "flattype/hash/Slot.h"
+
+namespace ftt {
+
+namespace detail {
+
+enum : size_t {
+  kCuckooBucketSize = 4,
+};
+
+// the two buckets of a key hash, never the same one; mask is the number
+// of buckets (a power of two, at least 2) - 1
+inline void cuckooBuckets(uint64_t hash, size_t mask, size_t& b1, size_t& b2) {
+  b1 = size_t(hash >> 32) & mask;
+  b2 = size_t((hash * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+  if (b2 == b1) {
+    b2 = b1 ^ 1;
+  }
+}
+
+} // namespace detail
+
+template <class S>
+struct CuckooSlotTraits;
+
+template <>
+struct CuckooSlotTraits<fbs::HSlot32> {
+  typedef fbs::CHMap32 map_type;
+  typedef fbs::CSlot32 slot_type;
+  typedef uint32_t key_type;
+  typedef uint32_t native_key_type;
+
+  static bool match(const slot_type& slot,
+                    const ::flatbuffers::Vector<
+                      ::flatbuffers::Offset<fbs::HSlot32>>*,
+                    key_type key,
+                    uint32_t) {
+    return slot.key() == key;
+  }
+
+  static slot_type makeSlot(uint32_t,
+                            uint32_t entry,
+                            const fbs::HSlot32T& obj) {
+    return slot_type(obj.key, entry);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<slot_type>* slots,
+      const std::vector<slot_type>* stash,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot32>>* entries) {
+    return fbs::CreateCHMap32Direct(fbb, slots, stash, entries);
+  }
+};
+
+template <>
+struct CuckooSlotTraits<fbs::HSlot64> {
+  typedef fbs::CHMap64 map_type;
+  typedef fbs::CSlot64 slot_type;
+  typedef uint64_t key_type;
+  typedef uint64_t native_key_type;
+
+  static bool match(const slot_type& slot,
+                    const ::flatbuffers::Vector<
+                      ::flatbuffers::Offset<fbs::HSlot64>>*,
+                    key_type key,
+                    uint32_t) {
+    return slot.key() == key;
+  }
+
+  static slot_type makeSlot(uint32_t,
+                            uint32_t entry,
+                            const fbs::HSlot64T& obj) {
+    return slot_type(entry, obj.key);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<slot_type>* slots,
+      const std::vector<slot_type>* stash,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot64>>* entries) {
+    return fbs::CreateCHMap64Direct(fbb, slots, stash, entries);
+  }
+};
+
+// string keys live in the entries, the slot hash filters most mismatches
+// before the key is read
+template <>
+struct CuckooSlotTraits<fbs::HSlotS> {
+  typedef fbs::CHMapS map_type;
+  typedef fbs::CSlotS slot_type;
+  typedef acc::StringPiece key_type;
+  typedef std::string native_key_type;
+
+  static bool match(const slot_type& slot,
+                    const ::flatbuffers::Vector<
+                      ::flatbuffers::Offset<fbs::HSlotS>>* entries,
+                    key_type key,
+                    uint32_t hash) {
+    return slot.hash() == hash &&
+      keyEquals(entries->Get(slot.entry() - 1)->key(), key);
+  }
+
+  static slot_type makeSlot(uint32_t hash,
+                            uint32_t entry,
+                            const fbs::HSlotST&) {
+    return slot_type(hash, entry);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<slot_type>* slots,
+      const std::vector<slot_type>* stash,
+      const std::vector<::flatbuffers::Offset<fbs::HSlotS>>* entries) {
+    return fbs::CreateCHMapSDirect(fbb, slots, stash, entries);
+  }
+};
+
+/*
+ * Read-only bucketized cuckoo hash map: a key is in one of two buckets of
+ * 4 slots, each a single cache line, so a lookup reads at most two lines
+ * of slots whatever the load, against the unbounded chains of HashMap.
+ * Both buckets are fetched before either is compared. Keys the build
+ * could not place are kept in a small stash, only read when not empty.
+ *
+ * The payload table (HSlot*) is only touched for the matching entry, or
+ * to compare a string key after its 32-bit hash matched.
+ */
+template <class S>
+class CuckooHashMapBase {
+ public:
+  typedef CuckooSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef typename traits_type::slot_type slot_type;
+  typedef S value_type;
+  typedef typename traits_type::key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator()
+      : owner_(nullptr),
+        entry_(0) {}
+    ConstIterator(const CuckooHashMapBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return *owner_->entries_->Get(entry_);
+    }
+    const value_type* operator->() const {
+      return owner_->entries_->Get(entry_);
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const CuckooHashMapBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  CuckooHashMapBase(const ft_type* hmap)
+    : ptr_(hmap) {
+    if (ptr_) {
+      slots_ = ptr_->slots();
+      stash_ = ptr_->stash();
+      entries_ = ptr_->entries();
+      bucketMask_ = slots_->size() / detail::kCuckooBucketSize - 1;
+    }
+  }
+
+  explicit CuckooHashMapBase(const uint8_t* data)
+    : CuckooHashMapBase(
+        data ? ::flatbuffers::GetRoot<ft_type>(data) : nullptr) {}
+  explicit CuckooHashMapBase(::flatbuffers::DetachedBuffer&& data)
+    : CuckooHashMapBase(data.data()) {
+    data_ = std::move(data);
+  }
+
+  CuckooHashMapBase(const CuckooHashMapBase&) = delete;
+  CuckooHashMapBase& operator=(const CuckooHashMapBase&) = delete;
+
+  CuckooHashMapBase(CuckooHashMapBase&&) = default;
+  CuckooHashMapBase& operator=(CuckooHashMapBase&&) = default;
+
+  size_t size() const {
+    return entries_ ? entries_->size() : 0;
+  }
+
+  // the keys outside of their buckets
+  size_t stashSize() const {
+    return stash_ ? stash_->size() : 0;
+  }
+
+  // the positions forEachRange() visits, one per key
+  size_t scanSize() const {
+    return size();
+  }
+
+  // call f(const value_type&) for the keys at positions [begin, end),
+  // disjoint ranges may be visited by several threads at the same time
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    end = std::min(end, size());
+    for (size_t i = begin; i < end; i++) {
+      f(*entries_->Get(i));
+    }
+  }
+
+  const_iterator find(const key_type& key) const {
+    return ConstIterator(*this, findEntry(key, hashKey(key)));
+  }
+
+  // look up n keys, both buckets of a group of keys are prefetched first
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    uint64_t hash[kBatchGroup];
+    for (size_t b = 0; b < n; b += kBatchGroup) {
+      size_t m = std::min(n - b, size_t(kBatchGroup));
+      for (size_t i = 0; i < m; i++) {
+        hash[i] = hashKey(keys[b + i]);
+        if (slots_) {
+          size_t b1, b2;
+          detail::cuckooBuckets(hash[i], bucketMask_, b1, b2);
+          prefetch(bucket(b1));
+          prefetch(bucket(b2));
+        }
+      }
+      for (size_t i = 0; i < m; i++) {
+        out[b + i] = ConstIterator(*this, findEntry(keys[b + i], hash[i]));
+      }
+    }
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, size());
+  }
+
+ private:
+  enum : uint32_t {
+    kBatchGroup = 16,
+  };
+
+  const slot_type* bucket(size_t b) const {
+    return slots_->Get(b * detail::kCuckooBucketSize);
+  }
+
+  uint32_t findIn(const slot_type* slots,
+                  size_t n,
+                  const key_type& key,
+                  uint32_t hash) const {
+    for (size_t i = 0; i < n; i++) {
+      if (slots[i].entry() != 0 &&
+          traits_type::match(slots[i], entries_, key, hash)) {
+        return slots[i].entry();
+      }
+    }
+    return 0;
+  }
+
+  uint32_t findEntry(const key_type& key, uint64_t hash) const {
+    if (!slots_ || slots_->size() == 0) {
+      return size();
+    }
+    size_t b1, b2;
+    detail::cuckooBuckets(hash, bucketMask_, b1, b2);
+    // the second line is in flight while the first is compared
+    prefetch(bucket(b2));
+    uint32_t entry = findIn(bucket(b1), detail::kCuckooBucketSize,
+                            key, uint32_t(hash));
+    if (entry == 0) {
+      entry = findIn(bucket(b2), detail::kCuckooBucketSize,
+                     key, uint32_t(hash));
+    }
+    if (entry == 0 && stash_->size() > 0) {
+      entry = findIn(stash_->Get(0), stash_->size(), key, uint32_t(hash));
+    }
+    return entry != 0 ? entry - 1 : size();
+  }
+
+  const ft_type* ptr_{nullptr};
+  const ::flatbuffers::Vector<const slot_type*>* slots_{nullptr};
+  const ::flatbuffers::Vector<const slot_type*>* stash_{nullptr};
+  const ::flatbuffers::Vector<
+    ::flatbuffers::Offset<value_type>>* entries_{nullptr};
+  size_t bucketMask_{0};
+  ::flatbuffers::DetachedBuffer data_;
+};
+
+typedef CuckooHashMapBase<fbs::HSlot32> CuckooHashMap32;
+typedef CuckooHashMapBase<fbs::HSlot64> CuckooHashMap64;
+typedef CuckooHashMapBase<fbs::HSlotS>  CuckooHashMapS;
+
+} // namespace ftt
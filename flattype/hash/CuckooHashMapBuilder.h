@@ -0,0 +1,329 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "accelerator/Bits.h"
+#include "flattype/Builder.h"
+#include "flattype/hash/CuckooHashMap.h"
+
+namespace ftt {
+
+/*
+ * Builds a CuckooHashMap in native arrays and serializes it once on
+ * finish(). A key taking a full bucket pair kicks a resident out to its
+ * alternate bucket, along a random walk of at most kMaxKicks moves; the
+ * key left over goes to the stash. When the stash is full too, or at
+ * maxLoadFactor, the table doubles and is rebuilt, so maxSize is a hint,
+ * not a limit.
+ */
+template <class S>
+class CuckooHashMapBuilderBase : public Builder {
+ public:
+  typedef CuckooSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef typename traits_type::slot_type slot_type;
+  typedef typename S::NativeTableType value_type;
+  typedef typename traits_type::native_key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator(const CuckooHashMapBuilderBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return owner_->entries_[entry_];
+    }
+    const value_type* operator->() const {
+      return &owner_->entries_[entry_];
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const CuckooHashMapBuilderBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  explicit CuckooHashMapBuilderBase(size_t maxSize)
+    : Builder() {
+    init(maxSize);
+  }
+
+  CuckooHashMapBuilderBase(size_t maxSize, FBB* fbb, bool owns = false)
+    : Builder(fbb, owns) {
+    init(maxSize);
+  }
+
+  void init(size_t maxSize, float maxLoadFactor = 0.9f) {
+    if (!(maxLoadFactor > 0.0f && maxLoadFactor < 1.0f)) {
+      throw std::invalid_argument(
+          "CuckooHashMap load factor must be in (0, 1)");
+    }
+    maxLoadFactor_ = maxLoadFactor;
+    entries_.clear();
+    entries_.reserve(maxSize);
+    hashes_.clear();
+    hashes_.reserve(maxSize);
+    rebuild(acc::nextPowTwo(
+            std::max(size_t(maxSize / maxLoadFactor) / kBucketSize + 1,
+                     size_t(2))));
+  }
+
+  CuckooHashMapBuilderBase(const CuckooHashMapBuilderBase&) = delete;
+  CuckooHashMapBuilderBase& operator=(const CuckooHashMapBuilderBase&)
+    = delete;
+
+  CuckooHashMapBuilderBase(CuckooHashMapBuilderBase&&) = default;
+  CuckooHashMapBuilderBase& operator=(CuckooHashMapBuilderBase&&) = default;
+
+  std::pair<const_iterator, bool>
+  findOrConstruct(const key_type& key, const std::vector<uint64_t>& indexes) {
+    uint64_t hash = hashKey(key);
+    uint32_t existing = findEntry(hash, key);
+    if (existing != 0) {
+      return std::make_pair(ConstIterator(*this, existing - 1), false);
+    }
+
+    value_type slotObj;
+    slotObj.key = key;
+    slotObj.indexes = indexes;
+    entries_.push_back(std::move(slotObj));
+    hashes_.push_back(hash);
+    uint32_t entry = uint32_t(entries_.size());
+    if (entry > maxEntries_ || !insert(entry)) {
+      rebuild((bucketMask_ + 1) * 2);
+    }
+
+    return std::make_pair(ConstIterator(*this, entry - 1), true);
+  }
+
+  const_iterator find(const key_type& key) const {
+    uint32_t entry = findEntry(hashKey(key), key);
+    return ConstIterator(*this, entry != 0 ? entry - 1 : entries_.size());
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  // the keys outside of their buckets
+  size_t stashSize() const {
+    return stash_.size();
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, entries_.size());
+  }
+
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  ::flatbuffers::Offset<ft_type> create() {
+    std::vector<slot_type> slots;
+    slots.reserve(cells_.size());
+    for (auto entry : cells_) {
+      slots.push_back(entry != 0 ? makeSlot(entry) : slot_type());
+    }
+    std::vector<slot_type> stash;
+    for (auto entry : stash_) {
+      stash.push_back(makeSlot(entry));
+    }
+    std::vector<::flatbuffers::Offset<S>> entries;
+    entries.reserve(entries_.size());
+    for (auto& entry : entries_) {
+      entries.push_back(S::Pack(*fbb_, &entry));
+    }
+    // slots is the first vector written, a bucket per cache line
+    fbb_->ForceVectorAlignment(slots.size(), sizeof(slot_type), 64);
+    return traits_type::create(*fbb_, &slots, &stash, &entries);
+  }
+
+  void finish() override {
+    if (finished_) {
+      return;
+    }
+    fbb_->Finish(create());
+    data_ = fbb_->Release();
+    finished_ = true;
+  }
+
+ private:
+  enum : size_t {
+    kBucketSize = detail::kCuckooBucketSize,
+    kMaxKicks = 500,
+    kMaxStash = 4,
+  };
+
+  slot_type makeSlot(uint32_t entry) const {
+    return traits_type::makeSlot(uint32_t(hashes_[entry - 1]), entry,
+                                 entries_[entry - 1]);
+  }
+
+  uint32_t findEntry(uint64_t hash, const key_type& key) const {
+    size_t b[2];
+    detail::cuckooBuckets(hash, bucketMask_, b[0], b[1]);
+    for (size_t bucket : b) {
+      for (size_t i = 0; i < kBucketSize; i++) {
+        uint32_t entry = cells_[bucket * kBucketSize + i];
+        if (entry != 0 && entries_[entry - 1].key == key) {
+          return entry;
+        }
+      }
+    }
+    for (auto entry : stash_) {
+      if (entries_[entry - 1].key == key) {
+        return entry;
+      }
+    }
+    return 0;
+  }
+
+  bool placeIn(size_t bucket, uint32_t entry) {
+    uint32_t* cells = &cells_[bucket * kBucketSize];
+    for (size_t i = 0; i < kBucketSize; i++) {
+      if (cells[i] == 0) {
+        cells[i] = entry;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // false if the key left over by the kick-out walk finds the stash full;
+  // that key is then in no cell, rebuild() places it again
+  bool insert(uint32_t entry) {
+    size_t b1, b2;
+    detail::cuckooBuckets(hashes_[entry - 1], bucketMask_, b1, b2);
+    if (placeIn(b1, entry) || placeIn(b2, entry)) {
+      return true;
+    }
+    size_t bucket = (nextRandom() & 1) ? b1 : b2;
+    for (size_t kick = 0; kick < kMaxKicks; kick++) {
+      size_t victim = nextRandom() & (kBucketSize - 1);
+      std::swap(entry, cells_[bucket * kBucketSize + victim]);
+      detail::cuckooBuckets(hashes_[entry - 1], bucketMask_, b1, b2);
+      bucket = bucket == b1 ? b2 : b1;
+      if (placeIn(bucket, entry)) {
+        return true;
+      }
+    }
+    if (stash_.size() < kMaxStash) {
+      stash_.push_back(entry);
+      return true;
+    }
+    return false;
+  }
+
+  // place all the entries in a table of at least buckets buckets
+  void rebuild(size_t buckets) {
+    for (;; buckets *= 2) {
+      if (buckets * kBucketSize > (size_t(1) << 32)) {
+        throw std::invalid_argument(
+            "CuckooHashMap capacity must fit in 32 bits");
+      }
+      cells_.assign(buckets * kBucketSize, 0);
+      stash_.clear();
+      bucketMask_ = buckets - 1;
+      maxEntries_ = std::min(size_t(cells_.size() * maxLoadFactor_),
+                             size_t(UINT32_MAX - 1));
+      uint32_t entry = 1;
+      while (entry <= entries_.size() && insert(entry)) {
+        entry++;
+      }
+      if (entry > entries_.size()) {
+        return;
+      }
+    }
+  }
+
+  // xorshift64, the walk is the same on every build of the same keys
+  uint64_t nextRandom() {
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    return random_;
+  }
+
+  std::vector<uint32_t> cells_;   // 1 + index into entries_, 0 is empty
+  std::vector<uint32_t> stash_;
+  std::vector<value_type> entries_;
+  std::vector<uint64_t> hashes_;  // key hash of each entry
+  size_t bucketMask_{0};
+  size_t maxEntries_{0};
+  float maxLoadFactor_{0.9f};
+  uint64_t random_{0x2545f4914f6cdd1dULL};
+};
+
+class CuckooHashMap32Builder : public CuckooHashMapBuilderBase<fbs::HSlot32> {
+ public:
+  explicit CuckooHashMap32Builder(size_t maxSize)
+    : CuckooHashMapBuilderBase(maxSize) {}
+  CuckooHashMap32Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : CuckooHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  CuckooHashMap32 toHashMap() { return toWrapper<CuckooHashMap32>(); }
+};
+
+class CuckooHashMap64Builder : public CuckooHashMapBuilderBase<fbs::HSlot64> {
+ public:
+  explicit CuckooHashMap64Builder(size_t maxSize)
+    : CuckooHashMapBuilderBase(maxSize) {}
+  CuckooHashMap64Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : CuckooHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  CuckooHashMap64 toHashMap() { return toWrapper<CuckooHashMap64>(); }
+};
+
+class CuckooHashMapSBuilder : public CuckooHashMapBuilderBase<fbs::HSlotS> {
+ public:
+  explicit CuckooHashMapSBuilder(size_t maxSize)
+    : CuckooHashMapBuilderBase(maxSize) {}
+  CuckooHashMapSBuilder(size_t maxSize, FBB* fbb, bool owns = false)
+    : CuckooHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  CuckooHashMapS toHashMap() { return toWrapper<CuckooHashMapS>(); }
+};
+
+} // namespace ftt
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "accelerator/Range.h"
+#include "flattype/CommonIDLs.h"
+#include "flattype/Util.h"
+#include "flattype/hash/Hash.h"
+#include "flattype/hash/Slot.h"
+
+namespace ftt {
+
+template <class S>
+struct FlatSlotTraits;
+
+template <>
+struct FlatSlotTraits<fbs::HSlot32> {
+  typedef fbs::FHMap32 map_type;
+  typedef fbs::FSlot32 slot_type;
+  typedef uint32_t key_type;
+  typedef uint32_t native_key_type;
+
+  static bool match(const slot_type& slot,
+                    const ::flatbuffers::Vector<
+                      ::flatbuffers::Offset<fbs::HSlot32>>*,
+                    key_type key) {
+    return slot.key() == key;
+  }
+
+  static slot_type makeSlot(uint32_t hash,
+                            uint32_t entry,
+                            const fbs::HSlot32T& obj) {
+    return slot_type(hash, entry, obj.key);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<slot_type>* slots,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot32>>* entries) {
+    return fbs::CreateFHMap32Direct(fbb, slots, entries);
+  }
+};
+
+template <>
+struct FlatSlotTraits<fbs::HSlot64> {
+  typedef fbs::FHMap64 map_type;
+  typedef fbs::FSlot64 slot_type;
+  typedef uint64_t key_type;
+  typedef uint64_t native_key_type;
+
+  static bool match(const slot_type& slot,
+                    const ::flatbuffers::Vector<
+                      ::flatbuffers::Offset<fbs::HSlot64>>*,
+                    key_type key) {
+    return slot.key() == key;
+  }
+
+  static slot_type makeSlot(uint32_t hash,
+                            uint32_t entry,
+                            const fbs::HSlot64T& obj) {
+    return slot_type(hash, entry, obj.key);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<slot_type>* slots,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot64>>* entries) {
+    return fbs::CreateFHMap64Direct(fbb, slots, entries);
+  }
+};
+
+// string keys live in the entries, the slot hash filters most mismatches
+// before the key is read
+template <>
+struct FlatSlotTraits<fbs::HSlotS> {
+  typedef fbs::FHMapS map_type;
+  typedef fbs::FSlotS slot_type;
+  typedef acc::StringPiece key_type;
+  typedef std::string native_key_type;
+
+  static bool match(const slot_type& slot,
+                    const ::flatbuffers::Vector<
+                      ::flatbuffers::Offset<fbs::HSlotS>>* entries,
+                    key_type key) {
+    auto s = entries->Get(slot.entry() - 1)->key();
+    return s && key == acc::StringPiece(s->data(), s->size());
+  }
+
+  static slot_type makeSlot(uint32_t hash,
+                            uint32_t entry,
+                            const fbs::HSlotST&) {
+    return slot_type(hash, entry);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<slot_type>* slots,
+      const std::vector<::flatbuffers::Offset<fbs::HSlotS>>* entries) {
+    return fbs::CreateFHMapSDirect(fbb, slots, entries);
+  }
+};
+
+/*
+ * Open addressing hash map whose slots are flatbuffers structs stored
+ * contiguously: hash, entry and (for integer keys) the key itself. A probe
+ * reads consecutive slots of the same cache line or two, the payload table
+ * (HSlot*) is only touched for the matching entry, or to compare a string
+ * key after its 32-bit hash matched.
+ *
+ * The map is built with Robin Hood insertion, so a probe stops as soon as
+ * it meets a slot closer to its home than the probe distance.
+ */
+template <class S>
+class FlatHashMapBase {
+ public:
+  typedef FlatSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef typename traits_type::slot_type slot_type;
+  typedef S value_type;
+  typedef typename traits_type::key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator()
+      : owner_(nullptr),
+        entry_(0) {}
+    ConstIterator(const FlatHashMapBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return *owner_->entries_->Get(entry_);
+    }
+    const value_type* operator->() const {
+      return owner_->entries_->Get(entry_);
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const FlatHashMapBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  FlatHashMapBase(const ft_type* hmap)
+    : ptr_(hmap) {
+    if (ptr_) {
+      slots_ = ptr_->slots();
+      entries_ = ptr_->entries();
+      slotMask_ = slots_->size() - 1;
+    }
+  }
+
+  explicit FlatHashMapBase(const uint8_t* data)
+    : FlatHashMapBase(data ? ::flatbuffers::GetRoot<ft_type>(data) : nullptr) {}
+  explicit FlatHashMapBase(::flatbuffers::DetachedBuffer&& data)
+    : FlatHashMapBase(data.data()) {
+    data_ = std::move(data);
+  }
+
+  FlatHashMapBase(const FlatHashMapBase&) = delete;
+  FlatHashMapBase& operator=(const FlatHashMapBase&) = delete;
+
+  FlatHashMapBase(FlatHashMapBase&&) = default;
+  FlatHashMapBase& operator=(FlatHashMapBase&&) = default;
+
+  size_t size() const {
+    return entries_ ? entries_->size() : 0;
+  }
+
+  // the positions forEachRange() visits, one per key
+  size_t scanSize() const {
+    return size();
+  }
+
+  // call f(const value_type&) for the keys at positions [begin, end),
+  // disjoint ranges may be visited by several threads at the same time
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    end = std::min(end, size());
+    for (size_t i = begin; i < end; i++) {
+      f(*entries_->Get(i));
+    }
+  }
+
+  const_iterator find(const key_type& key) const {
+    return ConstIterator(*this, findEntry(key, uint32_t(hashKey(key))));
+  }
+
+  // look up n keys, the home slots of a group are prefetched first
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    uint32_t hash[kBatchGroup];
+    for (size_t b = 0; b < n; b += kBatchGroup) {
+      size_t m = std::min(n - b, size_t(kBatchGroup));
+      for (size_t i = 0; i < m; i++) {
+        hash[i] = uint32_t(hashKey(keys[b + i]));
+        if (slots_) {
+          prefetch(slots_->Get(hash[i] & slotMask_));
+        }
+      }
+      for (size_t i = 0; i < m; i++) {
+        out[b + i] = ConstIterator(*this, findEntry(keys[b + i], hash[i]));
+      }
+    }
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, size());
+  }
+
+ private:
+  enum : uint32_t {
+    kBatchGroup = 16,
+  };
+
+  uint32_t findEntry(const key_type& key, uint32_t hash) const {
+    if (!slots_ || slots_->size() == 0) {
+      return size();
+    }
+    size_t pos = hash & slotMask_;
+    for (size_t dist = 0; ; dist++) {
+      const slot_type* slot = slots_->Get(pos);
+      if (slot->entry() == 0 || ((pos - slot->hash()) & slotMask_) < dist) {
+        return size();
+      }
+      if (slot->hash() == hash &&
+          traits_type::match(*slot, entries_, key)) {
+        return slot->entry() - 1;
+      }
+      pos = (pos + 1) & slotMask_;
+    }
+  }
+
+  const ft_type* ptr_{nullptr};
+  const ::flatbuffers::Vector<const slot_type*>* slots_{nullptr};
+  const ::flatbuffers::Vector<
+    ::flatbuffers::Offset<value_type>>* entries_{nullptr};
+  size_t slotMask_{0};
+  ::flatbuffers::DetachedBuffer data_;
+};
+
+typedef FlatHashMapBase<fbs::HSlot32> FlatHashMap32;
+typedef FlatHashMapBase<fbs::HSlot64> FlatHashMap64;
+typedef FlatHashMapBase<fbs::HSlotS>  FlatHashMapS;
+
+} // namespace ftt
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "accelerator/Bits.h"
+#include "flattype/Builder.h"
+#include "flattype/hash/FlatHashMap.h"
+
+namespace ftt {
+
+/*
+ * Builds a FlatHashMap in native arrays and serializes it once on
+ * finish(). The slot array grows by doubling when maxLoadFactor is
+ * reached, so maxSize is a hint, not a limit.
+ */
+template <class S>
+class FlatHashMapBuilderBase : public Builder {
+ public:
+  typedef FlatSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef typename traits_type::slot_type slot_type;
+  typedef typename S::NativeTableType value_type;
+  typedef typename traits_type::native_key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator(const FlatHashMapBuilderBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return owner_->entries_[entry_];
+    }
+    const value_type* operator->() const {
+      return &owner_->entries_[entry_];
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const FlatHashMapBuilderBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  explicit FlatHashMapBuilderBase(size_t maxSize)
+    : Builder() {
+    init(maxSize);
+  }
+
+  FlatHashMapBuilderBase(size_t maxSize, FBB* fbb, bool owns = false)
+    : Builder(fbb, owns) {
+    init(maxSize);
+  }
+
+  void init(size_t maxSize, float maxLoadFactor = 0.8f) {
+    if (!(maxLoadFactor > 0.0f && maxLoadFactor < 1.0f)) {
+      throw std::invalid_argument(
+          "FlatHashMap load factor must be in (0, 1)");
+    }
+    maxLoadFactor_ = maxLoadFactor;
+    entries_.clear();
+    entries_.reserve(maxSize);
+    resize(acc::nextPowTwo(std::max(size_t(maxSize / maxLoadFactor) + 1,
+                                    size_t(16))));
+  }
+
+  FlatHashMapBuilderBase(const FlatHashMapBuilderBase&) = delete;
+  FlatHashMapBuilderBase& operator=(const FlatHashMapBuilderBase&) = delete;
+
+  FlatHashMapBuilderBase(FlatHashMapBuilderBase&&) = default;
+  FlatHashMapBuilderBase& operator=(FlatHashMapBuilderBase&&) = default;
+
+  std::pair<const_iterator, bool>
+  findOrConstruct(const key_type& key, const std::vector<uint64_t>& indexes) {
+    uint32_t hash = uint32_t(hashKey(key));
+    uint32_t existing = findEntry(hash, key);
+    if (existing != 0) {
+      return std::make_pair(ConstIterator(*this, existing - 1), false);
+    }
+    if (entries_.size() >= maxEntries_) {
+      resize(cells_.size() * 2);
+    }
+
+    value_type slotObj;
+    slotObj.key = key;
+    slotObj.indexes = indexes;
+    entries_.push_back(std::move(slotObj));
+    place(Cell{hash, uint32_t(entries_.size())});
+
+    return std::make_pair(ConstIterator(*this, entries_.size() - 1), true);
+  }
+
+  const_iterator find(const key_type& key) const {
+    uint32_t entry = findEntry(uint32_t(hashKey(key)), key);
+    return ConstIterator(*this, entry != 0 ? entry - 1 : entries_.size());
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, entries_.size());
+  }
+
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  ::flatbuffers::Offset<ft_type> create() {
+    std::vector<slot_type> slots;
+    slots.reserve(cells_.size());
+    for (auto& cell : cells_) {
+      slots.push_back(cell.entry != 0
+                      ? traits_type::makeSlot(cell.hash, cell.entry,
+                                              entries_[cell.entry - 1])
+                      : slot_type());
+    }
+    std::vector<::flatbuffers::Offset<S>> entries;
+    entries.reserve(entries_.size());
+    for (auto& entry : entries_) {
+      entries.push_back(S::Pack(*fbb_, &entry));
+    }
+    return traits_type::create(*fbb_, &slots, &entries);
+  }
+
+  void finish() override {
+    if (finished_) {
+      return;
+    }
+    fbb_->Finish(create());
+    data_ = fbb_->Release();
+    finished_ = true;
+  }
+
+ private:
+  struct Cell {
+    uint32_t hash;
+    uint32_t entry;   // 1 + index into entries_, 0 is empty
+  };
+
+  uint32_t findEntry(uint32_t hash, const key_type& key) const {
+    size_t pos = hash & slotMask_;
+    for (size_t dist = 0; ; dist++) {
+      const Cell& cell = cells_[pos];
+      if (cell.entry == 0 || ((pos - cell.hash) & slotMask_) < dist) {
+        return 0;
+      }
+      if (cell.hash == hash && entries_[cell.entry - 1].key == key) {
+        return cell.entry;
+      }
+      pos = (pos + 1) & slotMask_;
+    }
+  }
+
+  // Robin Hood: take the slot of any entry closer to its home
+  void place(Cell cell) {
+    size_t pos = cell.hash & slotMask_;
+    for (size_t dist = 0; ; dist++) {
+      Cell& cur = cells_[pos];
+      if (cur.entry == 0) {
+        cur = cell;
+        return;
+      }
+      size_t curDist = (pos - cur.hash) & slotMask_;
+      if (curDist < dist) {
+        std::swap(cur, cell);
+        dist = curDist;
+      }
+      pos = (pos + 1) & slotMask_;
+    }
+  }
+
+  void resize(size_t capacity) {
+    if (capacity > (size_t(1) << 32)) {
+      throw std::invalid_argument(
+          "FlatHashMap capacity must fit in 32 bits");
+    }
+    std::vector<Cell> cells(capacity, Cell{0, 0});
+    cells_.swap(cells);
+    slotMask_ = capacity - 1;
+    maxEntries_ = std::min(size_t(capacity * maxLoadFactor_),
+                           size_t(UINT32_MAX - 1));
+    for (auto& cell : cells) {
+      if (cell.entry != 0) {
+        place(cell);
+      }
+    }
+  }
+
+  std::vector<Cell> cells_;
+  std::vector<value_type> entries_;
+  size_t slotMask_{0};
+  size_t maxEntries_{0};
+  float maxLoadFactor_{0.8f};
+};
+
+class FlatHashMap32Builder : public FlatHashMapBuilderBase<fbs::HSlot32> {
+ public:
+  explicit FlatHashMap32Builder(size_t maxSize)
+    : FlatHashMapBuilderBase(maxSize) {}
+  FlatHashMap32Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : FlatHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  FlatHashMap32 toHashMap() { return toWrapper<FlatHashMap32>(); }
+};
+
+class FlatHashMap64Builder : public FlatHashMapBuilderBase<fbs::HSlot64> {
+ public:
+  explicit FlatHashMap64Builder(size_t maxSize)
+    : FlatHashMapBuilderBase(maxSize) {}
+  FlatHashMap64Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : FlatHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  FlatHashMap64 toHashMap() { return toWrapper<FlatHashMap64>(); }
+};
+
+class FlatHashMapSBuilder : public FlatHashMapBuilderBase<fbs::HSlotS> {
+ public:
+  explicit FlatHashMapSBuilder(size_t maxSize)
+    : FlatHashMapBuilderBase(maxSize) {}
+  FlatHashMapSBuilder(size_t maxSize, FBB* fbb, bool owns = false)
+    : FlatHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  FlatHashMapS toHashMap() { return toWrapper<FlatHashMapS>(); }
+};
+
+} // namespace ftt
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "accelerator/Range.h"
+#include "flatbuffers/flatbuffers.h"
+
+namespace ftt {
+
+/*
+ * Hash functions of the serialized hash maps. Their results are part of
+ * the file format, so they must never change: integers are hashed with the
+ * 64-bit finalizer of MurmurHash3, strings with MurmurHash64A (seed 0) over
+ * their bytes, read as little-endian words.
+ */
+
+inline uint64_t hashInt(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+inline uint64_t hashBytes(const void* data, size_t len, uint64_t seed = 0) {
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+  const uint8_t* end = p + (len & ~size_t(7));
+  uint64_t h = seed ^ (len * m);
+
+  for (; p != end; p += 8) {
+    uint64_t k;
+    memcpy(&k, p, sizeof(k));
+    k = ::flatbuffers::EndianScalar(k);   // a no-op on little-endian hosts
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  switch (len & 7) {
+    case 7: h ^= uint64_t(p[6]) << 48;
+            // fallthrough
+    case 6: h ^= uint64_t(p[5]) << 40;
+            // fallthrough
+    case 5: h ^= uint64_t(p[4]) << 32;
+            // fallthrough
+    case 4: h ^= uint64_t(p[3]) << 24;
+            // fallthrough
+    case 3: h ^= uint64_t(p[2]) << 16;
+            // fallthrough
+    case 2: h ^= uint64_t(p[1]) << 8;
+            // fallthrough
+    case 1: h ^= uint64_t(p[0]);
+            h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+inline uint64_t hashKey(uint32_t key) {
+  return hashInt(key);
+}
+inline uint64_t hashKey(uint64_t key) {
+  return hashInt(key);
+}
+inline uint64_t hashKey(acc::StringPiece key) {
+  return hashBytes(key.data(), key.size());
+}
+inline uint64_t hashKey(const std::string& key) {
+  return hashBytes(key.data(), key.size());
+}
+inline uint64_t hashKey(const ::flatbuffers::String* key) {
+  return hashBytes(key->data(), key->size());
+}
+
+} // namespace ftt
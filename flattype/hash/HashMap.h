@@ -16,11 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
+#include <memory>
 
 #include "accelerator/Bits.h"
 #include "flattype/CommonIDLs.h"
 #include "flattype/Util.h"
+#include "flattype/flattype-config.h"
+#include "flattype/hash/LookupStats.h"
 #include "flattype/hash/Slot.h"
 
 namespace ftt {
@@ -33,24 +37,27 @@ class HashMapBase {
   typedef typename SlotIndexType<S>::type key_type;
 
   typedef struct ConstIterator {
+    ConstIterator()
+      : owner_(nullptr),
+        slot_(0) {}
     ConstIterator(const HashMapBase& owner, uint32_t slot)
-      : owner_(owner),
+      : owner_(&owner),
         slot_(slot) {}
 
     ConstIterator(const ConstIterator&) = default;
     ConstIterator& operator=(const ConstIterator&) = default;
 
     const value_type& operator*() const {
-      return *owner_.slots_[slot_];
+      return *owner_->slots_[slot_];
     }
     const value_type* operator->() const {
-      return owner_.slots_[slot_];
+      return owner_->slots_[slot_];
     }
 
     const ConstIterator& operator++() {
       while (slot_ > 0) {
         --slot_;
-        if (SlotState::state(owner_.slots_[slot_]) == SlotState::LINKED) {
+        if (SlotState::state(owner_->slots_[slot_]) == SlotState::LINKED) {
           break;
         }
       }
@@ -70,8 +77,13 @@ class HashMapBase {
       return !(*this == rhs);
     }
 
+    // the slot id, e.g. for the counters of hash/SlotCounters.h
+    uint32_t slot() const {
+      return slot_;
+    }
+
    private:
-    const HashMapBase& owner_;
+    const HashMapBase* owner_;
     uint32_t slot_;
   } const_iterator;
 
@@ -80,7 +92,9 @@ class HashMapBase {
  public:
   HashMapBase(const FT* hmap)
     : ptr_(hmap),
-      slots_(*hmap->slots()) {
+      slots_(*hmap->slots()),
+      entries_(hmap->entries()),
+      hashType_(hmap->hash()) {
     numSlots_ = slots_.size();
     slotMask_ = acc::nextPowTwo(numSlots_ * 4) - 1;
   }
@@ -98,8 +112,104 @@ class HashMapBase {
   HashMapBase(HashMapBase&&) = default;
   HashMapBase& operator=(HashMapBase&&) = default;
 
+  // string keys are looked up by content, without allocation
   const_iterator find(const key_type& key) const {
-    return ConstIterator(*this, find(key, keyToSlotIdx(key)));
+    return findWithHash(key, slotHash(hashType_, key));
+  }
+
+  // look up a key whose hash is already known, hash must be slotHash() of
+  // the key with getHashType()
+  const_iterator findWithHash(const key_type& key, uint64_t hash) const {
+    uint32_t home = hashToSlotIdx(hash);
+    uint32_t slot = find(key, home, slotFingerprint(hashType_, hash));
+#if FTT_HASH_STATS
+    if (detail::LookupSampler::sample()) {
+      sampleLookup(home, slot);
+    }
+#endif
+    return ConstIterator(*this, slot);
+  }
+
+  // the probe counts sampled by find(), see hash/LookupStats.h
+  LookupStats lookupStats() const {
+#if FTT_HASH_STATS
+    return sampler_->stats();
+#else
+    return LookupStats();
+#endif
+  }
+
+  // raw slot access, e.g. for hash/HashMapStats.h
+  size_t slotCount() const {
+    return numSlots_;
+  }
+  const value_type* slot(uint32_t i) const {
+    return slots_[i];
+  }
+
+  fbs::HashType getHashType() const {
+    return hashType_;
+  }
+
+  /*
+   * Look up n keys, out[i] is the result for keys[i]. Keys are resolved in
+   * groups: all bucket heads of a group are prefetched before any is read,
+   * then the first chain entries, so the cache misses of a group overlap.
+   */
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    uint32_t slot[kBatchGroup];
+    uint16_t fp[kBatchGroup];
+    for (size_t b = 0; b < n; b += kBatchGroup) {
+      size_t m = std::min(n - b, size_t(kBatchGroup));
+      for (size_t i = 0; i < m; i++) {
+        uint64_t hash = slotHash(hashType_, keys[b + i]);
+        slot[i] = hashToSlotIdx(hash);
+        fp[i] = slotFingerprint(hashType_, hash);
+        prefetch(slotOffset(slot[i]));
+      }
+      for (size_t i = 0; i < m; i++) {
+        prefetch(slots_[slot[i]]);
+      }
+      for (size_t i = 0; i < m; i++) {
+        slot[i] = SlotState::headAndState(slots_[slot[i]]) >> 2;
+        prefetch(slotOffset(slot[i]));
+      }
+      for (size_t i = 0; i < m; i++) {
+        prefetch(slots_[slot[i]]);
+      }
+      for (size_t i = 0; i < m; i++) {
+        out[b + i] = ConstIterator(*this, findInChain(keys[b + i],
+                                                      slot[i], fp[i]));
+      }
+    }
+  }
+
+  // the positions forEachRange() visits: the keys in insertion order if
+  // the map has its entry list, or else all the slots
+  size_t scanSize() const {
+    return entries_ ? entries_->size() : numSlots_;
+  }
+
+  /*
+   * Call f(const value_type&) for the keys at positions [begin, end) of
+   * the scan, without the empty slots the iterators step over. Disjoint
+   * ranges may be visited by several threads at the same time.
+   */
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    end = std::min(end, scanSize());
+    if (entries_) {
+      for (size_t i = begin; i < end; i++) {
+        f(*slots_[entries_->Get(i)]);
+      }
+    } else {
+      for (size_t i = std::max(begin, size_t(1)); i < end; i++) {
+        auto s = slots_[i];
+        if (SlotState::state(s) == SlotState::LINKED) {
+          f(*s);
+        }
+      }
+    }
   }
 
   const_iterator cbegin() const {
@@ -115,8 +225,7 @@ class HashMapBase {
   }
 
  private:
-  uint32_t keyToSlotIdx(const key_type& key) const {
-    size_t h = std::hash<key_type>()(key);
+  uint32_t hashToSlotIdx(size_t h) const {
     h &= slotMask_;
     while (h >= numSlots_) {
       h -= numSlots_;
@@ -124,21 +233,55 @@ class HashMapBase {
     return h;
   }
 
-  uint32_t find(const key_type& key, uint32_t slot) const {
-    auto hs = SlotState::headAndState(slots_[slot]);
-    for (slot = hs >> 2; slot != 0; slot = SlotState::next(slots_[slot])) {
-      if (key == slots_[slot]->key()) {
+  enum : uint32_t {
+    kBatchGroup = 16,
+  };
+
+  uint32_t find(const key_type& key, uint32_t slot, uint16_t fp) const {
+    return findInChain(key, SlotState::headAndState(slots_[slot]) >> 2, fp);
+  }
+
+  // the fingerprint rejects most other keys of the chain without reading
+  // their key
+  uint32_t findInChain(const key_type& key, uint32_t slot, uint16_t fp) const {
+    for (; slot != 0; slot = SlotState::next(slots_[slot])) {
+      auto s = slots_[slot];
+      if (SlotState::matches(s, fp) && keyEquals(s->key(), key)) {
         return slot;
       }
     }
     return 0;
   }
 
+  const void* slotOffset(uint32_t slot) const {
+    return slots_.Data() + slot * sizeof(::flatbuffers::uoffset_t);
+  }
+
+#if FTT_HASH_STATS
+  // walk the chain of home again, up to found (or to its end for a miss)
+  void sampleLookup(uint32_t home, uint32_t found) const {
+    uint64_t probes = 0;
+    uint32_t slot = SlotState::headAndState(slots_[home]) >> 2;
+    for (; slot != 0; slot = SlotState::next(slots_[slot])) {
+      probes++;
+      if (slot == found) {
+        break;
+      }
+    }
+    sampler_->record(found != 0, probes);
+  }
+
+  std::unique_ptr<detail::LookupSampler> sampler_{
+    new detail::LookupSampler()};
+#endif
+
   size_t numSlots_;
   size_t slotMask_;
 
   const FT* ptr_{nullptr};
   const ::flatbuffers::Vector<flatbuffers::Offset<value_type>>& slots_;
+  const ::flatbuffers::Vector<uint32_t>* entries_;
+  fbs::HashType hashType_;
   ::flatbuffers::DetachedBuffer data_;
 };
 
@@ -18,29 +18,50 @@
 
 namespace ftt {
 
+::flatbuffers::Offset<fbs::HMap32> HashMap32Builder::create() {
+  packBulk();
+  fillEmptySlots();
+  return fbs::CreateHMap32Direct(
+      *fbb_, &slots_, hashType_, &order_, counters(), uint8_t(columns_));
+}
+
 void HashMap32Builder::finish() {
   if (finished_) {
     return;
   }
-  fbb_->Finish(fbs::CreateHMap32Direct(*fbb_, &slots_));
+  fbb_->Finish(create());
   data_ = fbb_->Release();
   finished_ = true;
 }
 
+::flatbuffers::Offset<fbs::HMap64> HashMap64Builder::create() {
+  packBulk();
+  fillEmptySlots();
+  return fbs::CreateHMap64Direct(
+      *fbb_, &slots_, hashType_, &order_, counters(), uint8_t(columns_));
+}
+
 void HashMap64Builder::finish() {
   if (finished_) {
     return;
   }
-  fbb_->Finish(fbs::CreateHMap64Direct(*fbb_, &slots_));
+  fbb_->Finish(create());
   data_ = fbb_->Release();
   finished_ = true;
 }
 
+::flatbuffers::Offset<fbs::HMapS> HashMapSBuilder::create() {
+  packBulk();
+  fillEmptySlots();
+  return fbs::CreateHMapSDirect(
+      *fbb_, &slots_, hashType_, &order_, counters(), uint8_t(columns_));
+}
+
 void HashMapSBuilder::finish() {
   if (finished_) {
     return;
   }
-  fbb_->Finish(fbs::CreateHMapSDirect(*fbb_, &slots_));
+  fbb_->Finish(create());
   data_ = fbb_->Release();
   finished_ = true;
 }
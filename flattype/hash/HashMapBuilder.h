@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "accelerator/Random.h"
 #include "flattype/Builder.h"
+#include "flattype/hash/BloomFilter.h"
 #include "flattype/hash/HashMap.h"
 
 namespace ftt {
@@ -26,7 +30,9 @@ template <class S>
 class HashMapBuilderBase : public Builder {
  public:
   typedef S value_type;
-  typedef typename SlotIndexType<S>::type key_type;
+  typedef typename SlotKeyType<S>::type key_type;
+  typedef typename SlotIndexType<S>::type lookup_key_type;
+  typedef typename S::NativeTableType native_type;
 
   typedef struct ConstIterator {
     ConstIterator(const HashMapBuilderBase& owner, uint32_t slot)
@@ -98,7 +104,11 @@ class HashMapBuilderBase : public Builder {
 
     numSlots_ = capacity;
     slotMask_ = acc::nextPowTwo(capacity * 4) - 1;
-    slots_.resize(capacity);
+    slots_.assign(capacity, ::flatbuffers::Offset<value_type>());
+    // slot 0 is the nil of chains and iteration, mark it as in-use
+    slots_[0] = createSlot(SlotState::CONSTRUCTING);
+    size_ = 0;
+    order_.clear();
   }
 
   HashMapBuilderBase(const HashMapBuilderBase&) = delete;
@@ -109,36 +119,228 @@ class HashMapBuilderBase : public Builder {
 
   std::pair<const_iterator, bool>
   findOrConstruct(const key_type& key, const std::vector<uint64_t>& indexes) {
-    uint32_t const slot = keyToSlotIdx(key);
+    checkIncremental();
+    uint64_t hash = slotHash(hashType_, key);
+    uint16_t fp = slotFingerprint(hashType_, hash);
+    uint32_t const slot = hashToSlotIdx(hash);
     uint32_t prev = SlotState::headAndState(getSlot(slot));
 
-    uint32_t existing = find(key, slot);
+    uint32_t existing = find(key, slot, fp);
     if (existing != 0) {
       return std::make_pair(ConstIterator(*this, existing), false);
     }
 
-    typename value_type::NativeTableType slotObj;
-    slotObj.hs = SlotState::LINKED;
-    slotObj.next = prev >> 2;
-    slotObj.key = key;
-    slotObj.indexes = indexes;
-
     uint32_t idx = allocateNear(slot);
-    slots_[idx] = value_type::Pack(*fbb_, &slotObj);
-
     uint32_t after = idx << 2;
     if (slot == idx) {
       after += SlotState::LINKED;
     } else {
       after += (prev & 3);
     }
-    getSlot(slot)->mutate_hs(after);
 
+    // keep the chain head idx may hold for another slot
+    typename value_type::NativeTableType slotObj;
+    slotObj.hs = slot == idx
+      ? after
+      : (SlotState::headAndState(getSlot(idx)) & ~3u) + SlotState::LINKED;
+    slotObj.next = prev >> 2;
+    slotObj.key = key;
+    slotObj.indexes = indexes;
+    slotObj.fp = fp;
+    slots_[idx] = value_type::Pack(*fbb_, &slotObj);
+
+    if (slot != idx) {
+      // an empty slot gets a table only to hold its chain head
+      if (slots_[slot].IsNull()) {
+        slots_[slot] = createSlot(after);
+      } else {
+        ::flatbuffers::GetMutableTemporaryPointer(*fbb_, slots_[slot])
+          ->mutate_hs(after);
+      }
+    }
+
+    size_++;
+    order_.push_back(idx);
     return std::make_pair(ConstIterator(*this, idx), true);
   }
 
-  const_iterator find(const key_type& key) const {
-    return ConstIterator(*this, find(key, keyToSlotIdx(key)));
+  // the number of keys inserted
+  size_t size() const {
+    return size_;
+  }
+
+  // a Bloom filter of the keys for IndexBuilderBase::setFilter(), to be
+  // built before finish()
+  BloomFilter buildFilter(size_t bitsPerKey = 10) const {
+    BloomFilter filter(size_, bitsPerKey);
+    if (!slotEntry_.empty()) {
+      for (auto e : slotEntry_) {
+        if (e != 0) {
+          filter.add(hashKey(bulk_[e - 1].key));
+        }
+      }
+    } else {
+      for (auto slot : order_) {
+        filter.add(hashKey(getSlot(slot)->key()));
+      }
+    }
+    return filter;
+  }
+
+  // hash the keys with type, Legacy for maps read by older code; set it
+  // before adding keys
+  void setHashType(fbs::HashType type) {
+    if (size_ > 0) {
+      throw std::runtime_error("HashMap hash type must be set when empty");
+    }
+    hashType_ = type;
+  }
+
+  // write n zeroed counter words per slot, see hash/SlotCounters.h
+  void setCounterColumns(size_t n) {
+    if (n > 255) {
+      throw std::invalid_argument("HashMap counter columns must be < 256");
+    }
+    columns_ = n;
+  }
+
+  // raw slot access, e.g. for hash/HashMapStats.h; slots not written yet
+  // are null
+  size_t slotCount() const {
+    return numSlots_;
+  }
+  const value_type* slot(uint32_t i) const {
+    checkIncremental();
+    return getSlot(i);
+  }
+
+  const_iterator find(const lookup_key_type& key) const {
+    checkIncremental();
+    uint64_t hash = slotHash(hashType_, key);
+    return ConstIterator(
+        *this,
+        find(key, hashToSlotIdx(hash), slotFingerprint(hashType_, hash)));
+  }
+
+  /*
+   * Bulk build from all the entries (key, value and indexes) at once, in
+   * place of findOrConstruct. The entries are bucketed by home slot with a
+   * counting sort, the first entry of a bucket takes its home slot and the
+   * others take the next free slots in slot order, so the layout depends
+   * only on the input order and any load factor up to 1 works. Slots are
+   * kept in native form and serialized once by finish().
+   *
+   * A key repeated in entries keeps its first entry.
+   */
+  void build(std::vector<native_type>&& entries, float loadFactor = 0.95f) {
+    if (!(loadFactor > 0.0f && loadFactor <= 1.0f)) {
+      throw std::invalid_argument("HashMap load factor must be in (0, 1]");
+    }
+    if (cbegin() != cend() || !slotEntry_.empty()) {
+      throw std::runtime_error("HashMap is already built");
+    }
+    size_t n = entries.size();
+    size_t capacity = std::max(size_t(n / loadFactor), n) + 1;
+    if (capacity > (size_t{1} << (8 * sizeof(uint32_t) - 2))) {
+      throw std::invalid_argument(
+          "HashMap capacity must fit in IndexType with 2 bits left over");
+    }
+    numSlots_ = capacity;
+    slotMask_ = acc::nextPowTwo(capacity * 4) - 1;
+
+    // counting sort of the entries by home slot, stable in input order
+    std::vector<uint64_t> hashes(n);
+    std::vector<uint32_t> start(capacity + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+      hashes[i] = slotHash(hashType_, entries[i].key);
+      start[hashToSlotIdx(hashes[i]) + 1]++;
+    }
+    for (size_t h = 0; h < capacity; h++) {
+      start[h + 1] += start[h];
+    }
+    std::vector<uint32_t> order(n);
+    {
+      std::vector<uint32_t> pos(start.begin(), start.end() - 1);
+      for (size_t i = 0; i < n; i++) {
+        order[pos[hashToSlotIdx(hashes[i])]++] = i;
+      }
+    }
+
+    // slotEntry_[slot] is 1 + the entry held, the nil slot is taken
+    slotEntry_.assign(capacity, 0);
+    std::vector<bool> used(capacity, false);
+    used[0] = true;
+    for (size_t h = 1; h < capacity; h++) {
+      if (start[h] < start[h + 1]) {
+        used[h] = true;
+      }
+    }
+
+    std::vector<uint32_t> slotOf(n, 0);
+    uint32_t head0 = 0;
+    size_t cursor = 1;
+    bool wrapped = false;
+    std::vector<uint32_t> chain;
+    for (size_t h = 0; h < capacity; h++) {
+      chain.clear();
+      for (size_t j = start[h]; j < start[h + 1]; j++) {
+        uint32_t e = order[j];
+        bool repeated = false;
+        for (uint32_t slot : chain) {
+          uint32_t o = slotEntry_[slot] - 1;
+          if (hashes[o] == hashes[e] && entries[o].key == entries[e].key) {
+            repeated = true;
+            break;
+          }
+        }
+        if (repeated) {
+          continue;
+        }
+        uint32_t slot;
+        if (h != 0 && chain.empty()) {
+          slot = h;
+        } else {
+          if (!wrapped && cursor < h) {
+            cursor = h;
+          }
+          while (used[cursor]) {
+            if (++cursor == capacity) {
+              cursor = 1;
+              wrapped = true;
+            }
+          }
+          slot = cursor;
+          used[slot] = true;
+        }
+        slotEntry_[slot] = e + 1;
+        slotOf[e] = slot;
+        size_++;
+        entries[e].hs = SlotState::LINKED;
+        entries[e].next = 0;
+        entries[e].fp = slotFingerprint(hashType_, hashes[e]);
+        if (!chain.empty()) {
+          entries[slotEntry_[chain.back()] - 1].next = slot;
+        }
+        chain.push_back(slot);
+      }
+      if (!chain.empty()) {
+        if (h == 0) {
+          head0 = chain.front();
+        } else {
+          entries[slotEntry_[h] - 1].hs += chain.front() << 2;
+        }
+      }
+    }
+
+    order_.clear();
+    for (auto slot : slotOf) {
+      if (slot != 0) {
+        order_.push_back(slot);
+      }
+    }
+    bulk_ = std::move(entries);
+    slots_.assign(capacity, ::flatbuffers::Offset<value_type>());
+    slots_[0] = createSlot((head0 << 2) + SlotState::CONSTRUCTING);
   }
 
   const_iterator cbegin() const {
@@ -158,8 +360,13 @@ class HashMapBuilderBase : public Builder {
     kMaxAllocationTries = 1000,
   };
 
-  uint32_t keyToSlotIdx(const key_type& key) const {
-    size_t h = std::hash<key_type>()(key);
+  void checkIncremental() const {
+    if (!slotEntry_.empty()) {
+      throw std::runtime_error("HashMap is bulk built, finish() it first");
+    }
+  }
+
+  uint32_t hashToSlotIdx(size_t h) const {
     h &= slotMask_;
     while (h >= numSlots_) {
       h -= numSlots_;
@@ -167,10 +374,11 @@ class HashMapBuilderBase : public Builder {
     return h;
   }
 
-  uint32_t find(const key_type& key, uint32_t slot) const {
+  uint32_t find(const lookup_key_type& key, uint32_t slot, uint16_t fp) const {
     auto hs = SlotState::headAndState(getSlot(slot));
     for (slot = hs >> 2; slot != 0; slot = SlotState::next(getSlot(slot))) {
-      if (key == getSlot(slot)->key()) {
+      auto s = getSlot(slot);
+      if (SlotState::matches(s, fp) && keyEquals(s->key(), key)) {
         return slot;
       }
     }
@@ -180,7 +388,7 @@ class HashMapBuilderBase : public Builder {
   uint32_t allocateNear(uint32_t start) {
     for (uint32_t tries = 0; tries < kMaxAllocationTries; ++tries) {
       uint32_t slot = allocationAttempt(start, tries);
-      if (!getSlot(slot)) {
+      if (SlotState::state(getSlot(slot)) == SlotState::EMPTY) {
         return slot;
       }
     }
@@ -196,14 +404,60 @@ class HashMapBuilderBase : public Builder {
   }
 
   const value_type* getSlot(size_t i) const {
-    return ::flatbuffers::GetTemporaryPointer(*fbb_, slots_[i]);
+    return slots_[i].IsNull()
+      ? nullptr
+      : ::flatbuffers::GetTemporaryPointer(*fbb_, slots_[i]);
+  }
+
+  ::flatbuffers::Offset<value_type> createSlot(uint32_t hs) {
+    typename value_type::NativeTableType slotObj;
+    slotObj.hs = hs;
+    return value_type::Pack(*fbb_, &slotObj);
   }
 
   size_t numSlots_;
   size_t slotMask_;
+  std::vector<native_type> bulk_;
+  std::vector<uint32_t> slotEntry_;
+  size_t size_{0};
 
  protected:
-  const std::vector<flatbuffers::Offset<value_type>>& slots_;
+  // serialize the slots of a bulk build, each table is written once
+  void packBulk() {
+    for (size_t i = 0; i < slotEntry_.size(); i++) {
+      if (slotEntry_[i] != 0) {
+        slots_[i] = value_type::Pack(*fbb_, &bulk_[slotEntry_[i] - 1]);
+      }
+    }
+    slotEntry_.clear();
+    bulk_.clear();
+  }
+
+  // the serialized slot vector holds no null offsets, empty slots share
+  // one empty table
+  void fillEmptySlots() {
+    ::flatbuffers::Offset<value_type> empty;
+    for (auto& slot : slots_) {
+      if (slot.IsNull()) {
+        if (empty.IsNull()) {
+          empty = createSlot(SlotState::EMPTY);
+        }
+        slot = empty;
+      }
+    }
+  }
+
+  // the counters of the serialized map, none without counter columns
+  const std::vector<uint64_t>* counters() {
+    counters_.assign(columns_ * slots_.size(), 0);
+    return columns_ > 0 ? &counters_ : nullptr;
+  }
+
+  std::vector<flatbuffers::Offset<value_type>> slots_;
+  std::vector<uint32_t> order_;   // slot of each key in insertion order
+  std::vector<uint64_t> counters_;
+  size_t columns_{0};
+  fbs::HashType hashType_{fbs::HashType::Murmur};
 };
 
 class HashMap32Builder : public HashMapBuilderBase<fbs::HSlot32> {
@@ -213,6 +467,10 @@ class HashMap32Builder : public HashMapBuilderBase<fbs::HSlot32> {
   HashMap32Builder(size_t maxSize, FBB* fbb, bool owns = false)
     : HashMapBuilderBase(maxSize, fbb, owns) {}
 
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  ::flatbuffers::Offset<fbs::HMap32> create();
+
   void finish() override;
 
   HashMap32 toHashMap() { return toWrapper<HashMap32>(); }
@@ -225,6 +483,10 @@ class HashMap64Builder : public HashMapBuilderBase<fbs::HSlot64> {
   HashMap64Builder(size_t maxSize, FBB* fbb, bool owns = false)
     : HashMapBuilderBase(maxSize, fbb, owns) {}
 
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  ::flatbuffers::Offset<fbs::HMap64> create();
+
   void finish() override;
 
   HashMap64 toHashMap() { return toWrapper<HashMap64>(); }
@@ -237,6 +499,10 @@ class HashMapSBuilder : public HashMapBuilderBase<fbs::HSlotS> {
   HashMapSBuilder(size_t maxSize, FBB* fbb, bool owns = false)
     : HashMapBuilderBase(maxSize, fbb, owns) {}
 
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  ::flatbuffers::Offset<fbs::HMapS> create();
+
   void finish() override;
 
   HashMapS toHashMap() { return toWrapper<HashMapS>(); }
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flattype/hash/HashMapStats.h"
+
+#include "accelerator/Conv.h"
+
+namespace ftt {
+
+std::string HashMapStats::toString() const {
+  std::string out = acc::to<std::string>(
+      "slots=", slots, " keys=", keys,
+      " load=", loadFactor(), " empty=", emptyRatio(),
+      " hit=", meanHitProbes, "/", maxHitProbes,
+      " miss=", meanMissProbes, "/", maxMissProbes,
+      " bytes/key=", bytesPerKey(),
+      " (key=", keyBytes, " value=", valueBytes,
+      " indexes=", indexBytes, " table=", tableBytes, ")",
+      " chains=[");
+  for (size_t n = 0; n < chains.size(); n++) {
+    out += acc::to<std::string>(n ? " " : "", chains[n]);
+  }
+  out += "]";
+  return out;
+}
+
+} // namespace ftt
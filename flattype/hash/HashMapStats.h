@@ -0,0 +1,153 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "flattype/hash/HashMap.h"
+#include "flattype/hash/HashMapBuilder.h"
+
+namespace ftt {
+
+/*
+ * Layout quality of a chained HashMap, from a walk of all its chains.
+ * Probes count the chain entries a lookup visits: a hit at position p of
+ * its chain visits p entries, a miss visits the whole chain of its home
+ * slot, averaged over uniform home slots.
+ *
+ * Bytes are estimated from the flatbuffers layout of the slot tables:
+ * keys with their strings, indexes and postings vectors, inline scalars
+ * at 9 bytes and union values at 16, and as table overhead the slot
+ * vector, the table headers and the hs/next/fp fields, vtables excluded.
+ */
+struct HashMapStats {
+  size_t slots{0};
+  size_t keys{0};
+  size_t emptySlots{0};
+  std::vector<size_t> chains;   // [n]: home slots with a chain of n keys
+
+  double meanHitProbes{0};
+  size_t maxHitProbes{0};
+  double meanMissProbes{0};
+  size_t maxMissProbes{0};
+
+  size_t keyBytes{0};
+  size_t valueBytes{0};
+  size_t indexBytes{0};
+  size_t tableBytes{0};
+
+  double loadFactor() const {
+    return slots ? double(keys) / slots : 0.0;
+  }
+  double emptyRatio() const {
+    return slots ? double(emptySlots) / slots : 0.0;
+  }
+  double bytesPerKey() const {
+    return keys
+      ? double(keyBytes + valueBytes + indexBytes + tableBytes) / keys
+      : 0.0;
+  }
+
+  std::string toString() const;
+};
+
+namespace detail {
+
+inline size_t padded(size_t n) {
+  return (n + 3) & ~size_t(3);
+}
+
+inline size_t statsKeyBytes(uint32_t) {
+  return 4;
+}
+inline size_t statsKeyBytes(uint64_t) {
+  return 8;
+}
+inline size_t statsKeyBytes(const ::flatbuffers::String* key) {
+  return key ? 8 + padded(key->size() + 1) : 0;
+}
+
+template <class S>
+void addSlotBytes(const S* s, HashMapStats& stats) {
+  stats.keyBytes += statsKeyBytes(s->key());
+  if (s->indexes()) {
+    stats.indexBytes += 8 + 8 * s->indexes()->size();
+  }
+  if (s->postings()) {
+    stats.indexBytes += 8 + 4 * s->postings()->size();
+  }
+  if (hasInlineValue(s)) {
+    stats.valueBytes += 9;
+  } else if (s->value_type() != fbs::Any::NONE) {
+    stats.valueBytes += 16;
+  }
+  stats.tableBytes += 16;
+}
+
+// M is a HashMapBase or a HashMapBuilderBase
+template <class M>
+HashMapStats hashMapStats(const M& map) {
+  HashMapStats stats;
+  stats.slots = map.slotCount();
+  stats.tableBytes = 4 * stats.slots;
+  size_t hitProbes = 0;
+  for (uint32_t h = 0; h < stats.slots; h++) {
+    auto s = map.slot(h);
+    if (h != 0 && SlotState::state(s) == SlotState::EMPTY) {
+      stats.emptySlots++;
+    }
+    size_t n = 0;
+    uint32_t i = SlotState::headAndState(s) >> 2;
+    for (; i != 0; i = SlotState::next(map.slot(i))) {
+      auto c = map.slot(i);
+      n++;
+      hitProbes += n;
+      addSlotBytes(c, stats);
+    }
+    if (n >= stats.chains.size()) {
+      stats.chains.resize(n + 1, 0);
+    }
+    stats.chains[n]++;
+    stats.keys += n;
+  }
+  if (stats.keys > 0) {
+    stats.meanHitProbes = double(hitProbes) / stats.keys;
+  }
+  if (stats.slots > 0) {
+    stats.meanMissProbes = double(stats.keys) / stats.slots;
+  }
+  stats.maxHitProbes = stats.chains.size() - 1;
+  stats.maxMissProbes = stats.maxHitProbes;
+  return stats;
+}
+
+} // namespace detail
+
+template <class FT, class S>
+inline HashMapStats hashMapStats(const HashMapBase<FT, S>& map) {
+  return detail::hashMapStats(map);
+}
+
+// of the slots written so far, not while a bulk build is pending
+template <class S>
+inline HashMapStats hashMapStats(const HashMapBuilderBase<S>& builder) {
+  return detail::hashMapStats(builder);
+}
+
+} // namespace ftt
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ftt {
+
+/*
+ * Probe counts of sampled lookups. The maps sample one lookup in 64 when
+ * built with FTT_HASH_STATS (cmake -DFTT_HASH_STATS=ON), and cost nothing
+ * otherwise, in which case the stats stay zero.
+ */
+struct LookupStats {
+  uint64_t sampled{0};
+  uint64_t hits{0};
+  uint64_t hitProbes{0};    // chain entries visited by the sampled hits
+  uint64_t missProbes{0};   // and by the sampled misses
+  uint64_t maxProbes{0};
+
+  double meanHitProbes() const {
+    return hits ? double(hitProbes) / hits : 0.0;
+  }
+  double meanMissProbes() const {
+    return sampled > hits ? double(missProbes) / (sampled - hits) : 0.0;
+  }
+};
+
+namespace detail {
+
+class LookupSampler {
+ public:
+  enum : uint32_t {
+    kSampleMask = 63,
+  };
+
+  // per thread, so that sampling doesn't share a cache line
+  static bool sample() {
+    static thread_local uint32_t n = 0;
+    return (++n & kSampleMask) == 0;
+  }
+
+  void record(bool hit, uint64_t probes) {
+    sampled_.fetch_add(1, std::memory_order_relaxed);
+    if (hit) {
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      hitProbes_.fetch_add(probes, std::memory_order_relaxed);
+    } else {
+      missProbes_.fetch_add(probes, std::memory_order_relaxed);
+    }
+    uint64_t max = maxProbes_.load(std::memory_order_relaxed);
+    while (max < probes &&
+           !maxProbes_.compare_exchange_weak(max, probes,
+                                             std::memory_order_relaxed)) {
+    }
+  }
+
+  LookupStats stats() const {
+    LookupStats stats;
+    stats.sampled = sampled_.load(std::memory_order_relaxed);
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.hitProbes = hitProbes_.load(std::memory_order_relaxed);
+    stats.missProbes = missProbes_.load(std::memory_order_relaxed);
+    stats.maxProbes = maxProbes_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  std::atomic<uint64_t> sampled_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> hitProbes_{0};
+  std::atomic<uint64_t> missProbes_{0};
+  std::atomic<uint64_t> maxProbes_{0};
+};
+
+} // namespace detail
+
+} // namespace ftt
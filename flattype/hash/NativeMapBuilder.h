@@ -0,0 +1,172 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "flattype/Builder.h"
+
+namespace ftt {
+
+/*
+ * Collects the entries natively, with the same inputs as HashMap*Builder,
+ * and serializes them once on create(), which is all a map built this way
+ * has to provide.
+ */
+template <class S, class Traits>
+class NativeMapBuilderBase : public Builder {
+ public:
+  typedef Traits traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef typename S::NativeTableType value_type;
+  typedef typename traits_type::native_key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator(const NativeMapBuilderBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return owner_->entries_[entry_];
+    }
+    const value_type* operator->() const {
+      return &owner_->entries_[entry_];
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const NativeMapBuilderBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  explicit NativeMapBuilderBase(size_t maxSize)
+    : Builder() {
+    init(maxSize);
+  }
+
+  NativeMapBuilderBase(size_t maxSize, FBB* fbb, bool owns = false)
+    : Builder(fbb, owns) {
+    init(maxSize);
+  }
+
+  void init(size_t maxSize) {
+    entries_.clear();
+    entries_.reserve(maxSize);
+    index_.clear();
+    index_.reserve(maxSize);
+  }
+
+  NativeMapBuilderBase(const NativeMapBuilderBase&) = delete;
+  NativeMapBuilderBase& operator=(const NativeMapBuilderBase&) = delete;
+
+  NativeMapBuilderBase(NativeMapBuilderBase&&) = default;
+  NativeMapBuilderBase& operator=(NativeMapBuilderBase&&) = default;
+
+  std::pair<const_iterator, bool>
+  findOrConstruct(const key_type& key, const std::vector<uint64_t>& indexes) {
+    auto r = index_.emplace(key, uint32_t(entries_.size()));
+    if (r.second) {
+      value_type slotObj;
+      slotObj.key = key;
+      slotObj.indexes = indexes;
+      entries_.push_back(std::move(slotObj));
+    }
+    return std::make_pair(ConstIterator(*this, r.first->second), r.second);
+  }
+
+  // add all the entries, a repeated key keeps its first entry
+  void build(std::vector<value_type>&& entries) {
+    for (auto& entry : entries) {
+      if (index_.emplace(entry.key, uint32_t(entries_.size())).second) {
+        entries_.push_back(std::move(entry));
+      }
+    }
+  }
+
+  const_iterator find(const key_type& key) const {
+    auto it = index_.find(key);
+    return ConstIterator(*this, it != index_.end() ? it->second
+                                                   : entries_.size());
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, entries_.size());
+  }
+
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  virtual ::flatbuffers::Offset<ft_type> create() = 0;
+
+  void finish() override {
+    if (finished_) {
+      return;
+    }
+    fbb_->Finish(create());
+    data_ = fbb_->Release();
+    finished_ = true;
+  }
+
+ protected:
+  // pack the entries into the FBB in the given order
+  std::vector<::flatbuffers::Offset<S>>
+  packEntries(const std::vector<uint32_t>& order) {
+    std::vector<::flatbuffers::Offset<S>> entries;
+    entries.reserve(order.size());
+    for (auto i : order) {
+      entries.push_back(S::Pack(*fbb_, &entries_[i]));
+    }
+    return entries;
+  }
+
+  std::vector<value_type> entries_;
+
+ private:
+  std::unordered_map<key_type, uint32_t> index_;
+};
+
+} // namespace ftt
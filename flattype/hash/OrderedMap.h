@@ -0,0 +1,366 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "accelerator/Range.h"
+#include "flattype/CommonIDLs.h"
+#include "flattype/Util.h"
+#include "flattype/hash/Slot.h"
+
+namespace ftt {
+
+namespace detail {
+
+/*
+ * The first rank in [lo, hi) whose key is not less than key, in sorted
+ * keys. Interpolation narrows the range for a few steps, which finds
+ * keys of a smooth distribution in about log log n probes, then binary
+ * search finishes so that skewed keys cost at most log n more.
+ */
+template <class T>
+size_t interpolationLowerBound(const T* keys, size_t lo, size_t hi, T key) {
+  for (int step = 0; step < 4 && hi - lo > 16; step++) {
+    T a = keys[lo];
+    T b = keys[hi - 1];
+    if (key <= a) {
+      return lo;
+    }
+    if (key > b) {
+      return hi;
+    }
+    size_t mid = lo + size_t(double(key - a) / double(b - a) * (hi - 1 - lo));
+    mid = std::min(std::max(mid, lo), hi - 1);
+    if (keys[mid] < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return std::lower_bound(keys + lo, keys + hi, key) - keys;
+}
+
+// the first 8 bytes of key as a big-endian number, zero padded, which
+// orders as the keys do
+inline uint64_t keyPrefix(acc::StringPiece key) {
+  uint64_t prefix = 0;
+  size_t n = std::min(key.size(), size_t(8));
+  for (size_t i = 0; i < 8; i++) {
+    prefix <<= 8;
+    if (i < n) {
+      prefix |= uint8_t(key[i]);
+    }
+  }
+  return prefix;
+}
+
+} // namespace detail
+
+template <class S>
+struct OrderedSlotTraits;
+
+template <>
+struct OrderedSlotTraits<fbs::HSlot32> {
+  typedef fbs::OMap32 map_type;
+  typedef uint32_t key_type;
+  typedef uint32_t native_key_type;
+
+  static size_t lowerBound(const map_type* omap, key_type key) {
+    auto keys = omap->keys();
+    return detail::interpolationLowerBound(keys->data(), 0, keys->size(), key);
+  }
+
+  static bool match(const map_type* omap, size_t rank, key_type key) {
+    return omap->keys()->Get(rank) == key;
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<fbs::HSlot32T>& objs,
+      const std::vector<uint32_t>& order,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot32>>& entries) {
+    std::vector<uint32_t> keys;
+    keys.reserve(order.size());
+    for (auto i : order) {
+      keys.push_back(objs[i].key);
+    }
+    return fbs::CreateOMap32Direct(fbb, &keys, &entries);
+  }
+};
+
+template <>
+struct OrderedSlotTraits<fbs::HSlot64> {
+  typedef fbs::OMap64 map_type;
+  typedef uint64_t key_type;
+  typedef uint64_t native_key_type;
+
+  static size_t lowerBound(const map_type* omap, key_type key) {
+    auto keys = omap->keys();
+    return detail::interpolationLowerBound(keys->data(), 0, keys->size(), key);
+  }
+
+  static bool match(const map_type* omap, size_t rank, key_type key) {
+    return omap->keys()->Get(rank) == key;
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<fbs::HSlot64T>& objs,
+      const std::vector<uint32_t>& order,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot64>>& entries) {
+    std::vector<uint64_t> keys;
+    keys.reserve(order.size());
+    for (auto i : order) {
+      keys.push_back(objs[i].key);
+    }
+    return fbs::CreateOMap64Direct(fbb, &keys, &entries);
+  }
+};
+
+template <>
+struct OrderedSlotTraits<fbs::HSlotS> {
+  typedef fbs::OMapS map_type;
+  typedef acc::StringPiece key_type;
+  typedef std::string native_key_type;
+
+  // binary search of the prefix, then of the full keys among the equal
+  // prefixes
+  static size_t lowerBound(const map_type* omap, key_type key) {
+    auto prefixes = omap->prefixes()->data();
+    size_t n = omap->prefixes()->size();
+    uint64_t prefix = detail::keyPrefix(key);
+    auto equal = std::equal_range(prefixes, prefixes + n, prefix);
+    size_t lo = equal.first - prefixes;
+    size_t hi = equal.second - prefixes;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (stringPiece(omap->entries()->Get(mid)->key()) < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  static bool match(const map_type* omap, size_t rank, key_type key) {
+    return keyEquals(omap->entries()->Get(rank)->key(), key);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<fbs::HSlotST>& objs,
+      const std::vector<uint32_t>& order,
+      const std::vector<::flatbuffers::Offset<fbs::HSlotS>>& entries) {
+    std::vector<uint64_t> prefixes;
+    prefixes.reserve(order.size());
+    for (auto i : order) {
+      prefixes.push_back(detail::keyPrefix(objs[i].key));
+    }
+    return fbs::CreateOMapSDirect(fbb, &prefixes, &entries);
+  }
+};
+
+/*
+ * Read-only ordered map: exact lookups like the hash maps, plus
+ * lower_bound(), upper_bound() and range() over the key order. Iterators
+ * walk the keys in ascending order and give the HSlot of each key.
+ */
+template <class S>
+class OrderedMapBase {
+ public:
+  typedef OrderedSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef S value_type;
+  typedef typename traits_type::key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator()
+      : owner_(nullptr),
+        rank_(0) {}
+    ConstIterator(const OrderedMapBase& owner, uint32_t rank)
+      : owner_(&owner),
+        rank_(rank) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return *owner_->ptr_->entries()->Get(rank_);
+    }
+    const value_type* operator->() const {
+      return owner_->ptr_->entries()->Get(rank_);
+    }
+
+    const ConstIterator& operator++() {
+      ++rank_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    const ConstIterator& operator--() {
+      --rank_;
+      return *this;
+    }
+
+    ConstIterator operator--(int) {
+      auto prev = *this;
+      --*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return rank_ == rhs.rank_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+    // the position of the key in the key order
+    uint32_t rank() const {
+      return rank_;
+    }
+
+   private:
+    const OrderedMapBase* owner_;
+    uint32_t rank_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  OrderedMapBase(const ft_type* omap)
+    : ptr_(omap),
+      size_(omap ? omap->entries()->size() : 0) {}
+
+  explicit OrderedMapBase(const uint8_t* data)
+    : OrderedMapBase(
+        data ? ::flatbuffers::GetRoot<ft_type>(data) : nullptr) {}
+  explicit OrderedMapBase(::flatbuffers::DetachedBuffer&& data)
+    : OrderedMapBase(data.data()) {
+    data_ = std::move(data);
+  }
+
+  OrderedMapBase(const OrderedMapBase&) = delete;
+  OrderedMapBase& operator=(const OrderedMapBase&) = delete;
+
+  OrderedMapBase(OrderedMapBase&&) = default;
+  OrderedMapBase& operator=(OrderedMapBase&&) = default;
+
+  size_t size() const {
+    return size_;
+  }
+
+  // the positions forEachRange() visits, the ranks
+  size_t scanSize() const {
+    return size();
+  }
+
+  // call f(const value_type&) for the keys of ranks [begin, end) in
+  // order, disjoint ranges may be visited by several threads at once
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    end = std::min(end, size());
+    for (size_t i = begin; i < end; i++) {
+      f(*ptr_->entries()->Get(i));
+    }
+  }
+
+  const_iterator find(const key_type& key) const {
+    size_t rank = lowerBound(key);
+    return ConstIterator(
+        *this, rank < size_ && traits_type::match(ptr_, rank, key)
+               ? rank : size_);
+  }
+
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  // the first key not less than key
+  const_iterator lower_bound(const key_type& key) const {
+    return ConstIterator(*this, lowerBound(key));
+  }
+
+  // the first key greater than key
+  const_iterator upper_bound(const key_type& key) const {
+    size_t rank = lowerBound(key);
+    if (rank < size_ && traits_type::match(ptr_, rank, key)) {
+      rank++;
+    }
+    return ConstIterator(*this, rank);
+  }
+
+  // the keys in [begin, end)
+  std::pair<const_iterator, const_iterator>
+  range(const key_type& begin, const key_type& end) const {
+    auto first = lower_bound(begin);
+    auto last = lower_bound(end);
+    if (last.rank() < first.rank()) {
+      last = first;
+    }
+    return std::make_pair(first, last);
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, size_);
+  }
+
+ private:
+  size_t lowerBound(const key_type& key) const {
+    return size_ > 0 ? traits_type::lowerBound(ptr_, key) : 0;
+  }
+
+  const ft_type* ptr_{nullptr};
+  uint32_t size_{0};
+  ::flatbuffers::DetachedBuffer data_;
+};
+
+typedef OrderedMapBase<fbs::HSlot32> OrderedMap32;
+typedef OrderedMapBase<fbs::HSlot64> OrderedMap64;
+typedef OrderedMapBase<fbs::HSlotS>  OrderedMapS;
+
+// the keys of a string map starting with prefix
+inline std::pair<OrderedMapS::const_iterator, OrderedMapS::const_iterator>
+prefixRange(const OrderedMapS& omap, acc::StringPiece prefix) {
+  std::string next = prefix.str();
+  while (!next.empty() && uint8_t(next.back()) == 0xff) {
+    next.pop_back();
+  }
+  if (next.empty()) {
+    return std::make_pair(omap.lower_bound(prefix), omap.cend());
+  }
+  next.back() = char(uint8_t(next.back()) + 1);
+  return omap.range(prefix, next);
+}
+
+} // namespace ftt
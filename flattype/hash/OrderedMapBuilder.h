@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "flattype/hash/NativeMapBuilder.h"
+#include "flattype/hash/OrderedMap.h"
+
+namespace ftt {
+
+/*
+ * Sorts the collected entries by key once on create().
+ */
+template <class S>
+class OrderedMapBuilderBase
+  : public NativeMapBuilderBase<S, OrderedSlotTraits<S>> {
+ public:
+  typedef NativeMapBuilderBase<S, OrderedSlotTraits<S>> base_type;
+  typedef typename base_type::traits_type traits_type;
+  typedef typename base_type::ft_type ft_type;
+
+  explicit OrderedMapBuilderBase(size_t maxSize)
+    : base_type(maxSize) {}
+  OrderedMapBuilderBase(size_t maxSize, FBB* fbb, bool owns = false)
+    : base_type(maxSize, fbb, owns) {}
+
+  ::flatbuffers::Offset<ft_type> create() override {
+    auto& entries = this->entries_;
+    std::vector<uint32_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      return entries[a].key < entries[b].key;
+    });
+    return traits_type::create(*this->fbb_, entries, order,
+                               this->packEntries(order));
+  }
+};
+
+class OrderedMap32Builder : public OrderedMapBuilderBase<fbs::HSlot32> {
+ public:
+  explicit OrderedMap32Builder(size_t maxSize)
+    : OrderedMapBuilderBase(maxSize) {}
+  OrderedMap32Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : OrderedMapBuilderBase(maxSize, fbb, owns) {}
+
+  OrderedMap32 toOrderedMap() { return toWrapper<OrderedMap32>(); }
+};
+
+class OrderedMap64Builder : public OrderedMapBuilderBase<fbs::HSlot64> {
+ public:
+  explicit OrderedMap64Builder(size_t maxSize)
+    : OrderedMapBuilderBase(maxSize) {}
+  OrderedMap64Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : OrderedMapBuilderBase(maxSize, fbb, owns) {}
+
+  OrderedMap64 toOrderedMap() { return toWrapper<OrderedMap64>(); }
+};
+
+class OrderedMapSBuilder : public OrderedMapBuilderBase<fbs::HSlotS> {
+ public:
+  explicit OrderedMapSBuilder(size_t maxSize)
+    : OrderedMapBuilderBase(maxSize) {}
+  OrderedMapSBuilder(size_t maxSize, FBB* fbb, bool owns = false)
+    : OrderedMapBuilderBase(maxSize, fbb, owns) {}
+
+  OrderedMapS toOrderedMap() { return toWrapper<OrderedMapS>(); }
+};
+
+} // namespace ftt
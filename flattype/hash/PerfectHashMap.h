@@ -0,0 +1,314 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "accelerator/Range.h"
+#include "flattype/CommonIDLs.h"
+#include "flattype/Util.h"
+#include "flattype/hash/Hash.h"
+#include "flattype/hash/Slot.h"
+
+namespace ftt {
+
+namespace detail {
+
+inline uint64_t perfectHash(uint64_t hash, uint64_t seed) {
+  return hashInt(hash ^ seed);
+}
+
+// skewed as in PTHash: 60% of the keys go to the first 30% of the buckets
+inline size_t perfectBucket(uint64_t h, size_t buckets) {
+  const uint64_t kSplit = 0x99999999;
+  uint64_t u = h >> 32;
+  uint64_t dense = buckets * 3 / 10;
+  if (dense == 0) {
+    return size_t((u * buckets) >> 32);
+  }
+  if (u < kSplit) {
+    return size_t(u * dense / kSplit);
+  }
+  return size_t(dense + (u - kSplit) * (buckets - dense) /
+                        ((uint64_t(1) << 32) - kSplit));
+}
+
+inline size_t perfectPosition(uint64_t h, uint16_t pilot, size_t tableSize) {
+  return size_t((h ^ hashInt(pilot)) % tableSize);
+}
+
+} // namespace detail
+
+struct PerfectHashLayout {
+  uint64_t seed{0};
+  std::vector<uint16_t> pilots;
+  std::vector<uint32_t> remap;
+  std::vector<uint32_t> positions;  // final position of each key
+};
+
+template <class S>
+struct PerfectSlotTraits;
+
+template <>
+struct PerfectSlotTraits<fbs::HSlot32> {
+  typedef fbs::PHMap32 map_type;
+  typedef uint32_t key_type;
+  typedef uint32_t native_key_type;
+
+  static bool match(const map_type* hmap, size_t pos, key_type key, uint64_t) {
+    return hmap->keys()->Get(pos) == key;
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const PerfectHashLayout& layout,
+      const std::vector<fbs::HSlot32T>& objs,
+      const std::vector<uint32_t>& order,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot32>>& entries) {
+    std::vector<uint32_t> keys;
+    keys.reserve(order.size());
+    for (auto i : order) {
+      keys.push_back(objs[i].key);
+    }
+    return fbs::CreatePHMap32Direct(
+        fbb, layout.seed, &layout.pilots, &layout.remap, &keys, &entries);
+  }
+};
+
+template <>
+struct PerfectSlotTraits<fbs::HSlot64> {
+  typedef fbs::PHMap64 map_type;
+  typedef uint64_t key_type;
+  typedef uint64_t native_key_type;
+
+  static bool match(const map_type* hmap, size_t pos, key_type key, uint64_t) {
+    return hmap->keys()->Get(pos) == key;
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const PerfectHashLayout& layout,
+      const std::vector<fbs::HSlot64T>& objs,
+      const std::vector<uint32_t>& order,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot64>>& entries) {
+    std::vector<uint64_t> keys;
+    keys.reserve(order.size());
+    for (auto i : order) {
+      keys.push_back(objs[i].key);
+    }
+    return fbs::CreatePHMap64Direct(
+        fbb, layout.seed, &layout.pilots, &layout.remap, &keys, &entries);
+  }
+};
+
+template <>
+struct PerfectSlotTraits<fbs::HSlotS> {
+  typedef fbs::PHMapS map_type;
+  typedef acc::StringPiece key_type;
+  typedef std::string native_key_type;
+
+  static bool match(const map_type* hmap, size_t pos, key_type key,
+                    uint64_t hash) {
+    return hmap->fps()->Get(pos) == slotFingerprint(hash) &&
+      keyEquals(hmap->entries()->Get(pos)->key(), key);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const PerfectHashLayout& layout,
+      const std::vector<fbs::HSlotST>& objs,
+      const std::vector<uint32_t>& order,
+      const std::vector<::flatbuffers::Offset<fbs::HSlotS>>& entries) {
+    std::vector<uint16_t> fps;
+    fps.reserve(order.size());
+    for (auto i : order) {
+      fps.push_back(slotFingerprint(hashKey(objs[i].key)));
+    }
+    return fbs::CreatePHMapSDirect(
+        fbb, layout.seed, &layout.pilots, &layout.remap, &fps, &entries);
+  }
+};
+
+/*
+ * Read-only minimal perfect hash map. Every key has a single candidate
+ * position found from its bucket pilot, so a lookup reads one pilot and
+ * one key (or fingerprint) to accept or reject the key. The entries are
+ * dense, position i holds entry i.
+ */
+template <class S>
+class PerfectHashMapBase {
+ public:
+  typedef PerfectSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef S value_type;
+  typedef typename traits_type::key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator()
+      : owner_(nullptr),
+        entry_(0) {}
+    ConstIterator(const PerfectHashMapBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return *owner_->ptr_->entries()->Get(entry_);
+    }
+    const value_type* operator->() const {
+      return owner_->ptr_->entries()->Get(entry_);
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const PerfectHashMapBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  PerfectHashMapBase(const ft_type* hmap)
+    : ptr_(hmap) {
+    if (ptr_) {
+      size_ = ptr_->entries()->size();
+      tableSize_ = size_ + ptr_->remap()->size();
+    }
+  }
+
+  explicit PerfectHashMapBase(const uint8_t* data)
+    : PerfectHashMapBase(
+        data ? ::flatbuffers::GetRoot<ft_type>(data) : nullptr) {}
+  explicit PerfectHashMapBase(::flatbuffers::DetachedBuffer&& data)
+    : PerfectHashMapBase(data.data()) {
+    data_ = std::move(data);
+  }
+
+  PerfectHashMapBase(const PerfectHashMapBase&) = delete;
+  PerfectHashMapBase& operator=(const PerfectHashMapBase&) = delete;
+
+  PerfectHashMapBase(PerfectHashMapBase&&) = default;
+  PerfectHashMapBase& operator=(PerfectHashMapBase&&) = default;
+
+  size_t size() const {
+    return size_;
+  }
+
+  // the positions forEachRange() visits, one per key
+  size_t scanSize() const {
+    return size();
+  }
+
+  // call f(const value_type&) for the keys at positions [begin, end),
+  // disjoint ranges may be visited by several threads at the same time
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    end = std::min(end, size());
+    for (size_t i = begin; i < end; i++) {
+      f(*ptr_->entries()->Get(i));
+    }
+  }
+
+  const_iterator find(const key_type& key) const {
+    uint64_t hash = hashKey(key);
+    return ConstIterator(*this, findEntry(key, hash, bucketOf(hash)));
+  }
+
+  // look up n keys, the pilots of a group of keys are prefetched first
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    uint64_t hash[kBatchGroup];
+    size_t bucket[kBatchGroup];
+    for (size_t b = 0; b < n; b += kBatchGroup) {
+      size_t m = std::min(n - b, size_t(kBatchGroup));
+      for (size_t i = 0; i < m; i++) {
+        hash[i] = hashKey(keys[b + i]);
+        bucket[i] = bucketOf(hash[i]);
+        if (size_ > 0) {
+          prefetch(ptr_->pilots()->data() + bucket[i]);
+        }
+      }
+      for (size_t i = 0; i < m; i++) {
+        out[b + i] = ConstIterator(
+            *this, findEntry(keys[b + i], hash[i], bucket[i]));
+      }
+    }
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, size_);
+  }
+
+ private:
+  enum : uint32_t {
+    kBatchGroup = 16,
+  };
+
+  size_t bucketOf(uint64_t hash) const {
+    return size_ > 0
+      ? detail::perfectBucket(detail::perfectHash(hash, ptr_->seed()),
+                              ptr_->pilots()->size())
+      : 0;
+  }
+
+  uint32_t findEntry(const key_type& key, uint64_t hash, size_t bucket) const {
+    if (size_ == 0) {
+      return 0;
+    }
+    size_t pos = detail::perfectPosition(
+        detail::perfectHash(hash, ptr_->seed()),
+        ptr_->pilots()->Get(bucket),
+        tableSize_);
+    if (pos >= size_) {
+      pos = ptr_->remap()->Get(pos - size_);
+    }
+    return traits_type::match(ptr_, pos, key, hash) ? pos : size_;
+  }
+
+  const ft_type* ptr_{nullptr};
+  uint32_t size_{0};
+  size_t tableSize_{0};
+  ::flatbuffers::DetachedBuffer data_;
+};
+
+typedef PerfectHashMapBase<fbs::HSlot32> PerfectHashMap32;
+typedef PerfectHashMapBase<fbs::HSlot64> PerfectHashMap64;
+typedef PerfectHashMapBase<fbs::HSlotS>  PerfectHashMapS;
+
+} // namespace ftt
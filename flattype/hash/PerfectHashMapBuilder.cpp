@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flattype/hash/PerfectHashMapBuilder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ftt {
+
+namespace {
+
+enum : size_t {
+  kKeysPerBucket = 6,
+  kMaxPilot = 65535,
+  kMaxSeeds = 16,
+};
+
+bool searchPilots(const std::vector<uint64_t>& hashes,
+                  uint64_t seed,
+                  PerfectHashLayout& layout) {
+  size_t n = hashes.size();
+  size_t buckets = std::max(n / kKeysPerBucket, size_t(1));
+  size_t tableSize = n + (n + 99) / 100;
+
+  std::vector<uint64_t> h(n);
+  std::vector<uint32_t> start(buckets + 1, 0);
+  for (size_t i = 0; i < n; i++) {
+    h[i] = detail::perfectHash(hashes[i], seed);
+    start[detail::perfectBucket(h[i], buckets) + 1]++;
+  }
+  size_t maxBucket = 0;
+  for (size_t b = 0; b < buckets; b++) {
+    maxBucket = std::max(maxBucket, size_t(start[b + 1]));
+    start[b + 1] += start[b];
+  }
+  std::vector<uint32_t> keys(n);
+  {
+    std::vector<uint32_t> pos(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < n; i++) {
+      keys[pos[detail::perfectBucket(h[i], buckets)]++] = i;
+    }
+  }
+  // the largest buckets first, by a counting sort on their sizes
+  std::vector<uint32_t> order;
+  order.reserve(buckets);
+  {
+    std::vector<std::vector<uint32_t>> bySize(maxBucket + 1);
+    for (size_t b = 0; b < buckets; b++) {
+      bySize[start[b + 1] - start[b]].push_back(b);
+    }
+    for (size_t k = maxBucket; k > 0; k--) {
+      order.insert(order.end(), bySize[k].begin(), bySize[k].end());
+    }
+  }
+
+  layout.seed = seed;
+  layout.pilots.assign(buckets, 0);
+  layout.positions.assign(n, 0);
+  std::vector<bool> taken(tableSize, false);
+  std::vector<size_t> pos(maxBucket);
+  for (auto b : order) {
+    size_t size = start[b + 1] - start[b];
+    const uint32_t* bucket = keys.data() + start[b];
+    size_t pilot = 0;
+    for (; pilot <= kMaxPilot; pilot++) {
+      size_t k = 0;
+      for (; k < size; k++) {
+        pos[k] = detail::perfectPosition(h[bucket[k]], pilot, tableSize);
+        if (taken[pos[k]] ||
+            std::find(pos.begin(), pos.begin() + k, pos[k]) !=
+              pos.begin() + k) {
+          break;
+        }
+      }
+      if (k == size) {
+        break;
+      }
+    }
+    if (pilot > kMaxPilot) {
+      return false;
+    }
+    layout.pilots[b] = uint16_t(pilot);
+    for (size_t k = 0; k < size; k++) {
+      taken[pos[k]] = true;
+      layout.positions[bucket[k]] = pos[k];
+    }
+  }
+
+  // move the positions past n to the free positions below n
+  layout.remap.assign(tableSize - n, 0);
+  size_t hole = 0;
+  for (size_t p = n; p < tableSize; p++) {
+    if (taken[p]) {
+      while (taken[hole]) {
+        hole++;
+      }
+      layout.remap[p - n] = hole++;
+    }
+  }
+  for (auto& p : layout.positions) {
+    if (p >= n) {
+      p = layout.remap[p - n];
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+PerfectHashLayout buildPerfectHash(const std::vector<uint64_t>& hashes) {
+  if (hashes.size() >= (size_t(1) << 32) - hashes.size() / 50) {
+    throw std::invalid_argument("PerfectHashMap size must fit in 32 bits");
+  }
+  PerfectHashLayout layout;
+  if (hashes.empty()) {
+    return layout;
+  }
+  for (size_t i = 0; i < kMaxSeeds; i++) {
+    if (searchPilots(hashes, hashInt(i + 1), layout)) {
+      return layout;
+    }
+  }
+  throw std::runtime_error("PerfectHashMap found no pilots, repeated hash?");
+}
+
+} // namespace ftt
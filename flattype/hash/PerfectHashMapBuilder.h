@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "flattype/hash/NativeMapBuilder.h"
+#include "flattype/hash/PerfectHashMap.h"
+
+namespace ftt {
+
+/*
+ * Place the distinct key hashes at positions 0..n-1, keeping 99% of the
+ * table used while searching pilots, with 6 keys per bucket on average.
+ * Throws std::runtime_error if no seed works, e.g. for repeated hashes.
+ */
+PerfectHashLayout buildPerfectHash(const std::vector<uint64_t>& hashes);
+
+/*
+ * Computes the perfect hash of the collected entries once on create().
+ */
+template <class S>
+class PerfectHashMapBuilderBase
+  : public NativeMapBuilderBase<S, PerfectSlotTraits<S>> {
+ public:
+  typedef NativeMapBuilderBase<S, PerfectSlotTraits<S>> base_type;
+  typedef typename base_type::traits_type traits_type;
+  typedef typename base_type::ft_type ft_type;
+
+  explicit PerfectHashMapBuilderBase(size_t maxSize)
+    : base_type(maxSize) {}
+  PerfectHashMapBuilderBase(size_t maxSize, FBB* fbb, bool owns = false)
+    : base_type(maxSize, fbb, owns) {}
+
+  ::flatbuffers::Offset<ft_type> create() override {
+    auto& entries = this->entries_;
+    std::vector<uint64_t> hashes;
+    hashes.reserve(entries.size());
+    for (auto& entry : entries) {
+      hashes.push_back(hashKey(entry.key));
+    }
+    PerfectHashLayout layout = buildPerfectHash(hashes);
+    std::vector<uint32_t> order(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+      order[layout.positions[i]] = i;
+    }
+    return traits_type::create(*this->fbb_, layout, entries, order,
+                               this->packEntries(order));
+  }
+};
+
+class PerfectHashMap32Builder
+  : public PerfectHashMapBuilderBase<fbs::HSlot32> {
+ public:
+  explicit PerfectHashMap32Builder(size_t maxSize)
+    : PerfectHashMapBuilderBase(maxSize) {}
+  PerfectHashMap32Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : PerfectHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  PerfectHashMap32 toHashMap() { return toWrapper<PerfectHashMap32>(); }
+};
+
+class PerfectHashMap64Builder
+  : public PerfectHashMapBuilderBase<fbs::HSlot64> {
+ public:
+  explicit PerfectHashMap64Builder(size_t maxSize)
+    : PerfectHashMapBuilderBase(maxSize) {}
+  PerfectHashMap64Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : PerfectHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  PerfectHashMap64 toHashMap() { return toWrapper<PerfectHashMap64>(); }
+};
+
+class PerfectHashMapSBuilder
+  : public PerfectHashMapBuilderBase<fbs::HSlotS> {
+ public:
+  explicit PerfectHashMapSBuilder(size_t maxSize)
+    : PerfectHashMapBuilderBase(maxSize) {}
+  PerfectHashMapSBuilder(size_t maxSize, FBB* fbb, bool owns = false)
+    : PerfectHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  PerfectHashMapS toHashMap() { return toWrapper<PerfectHashMapS>(); }
+};
+
+} // namespace ftt
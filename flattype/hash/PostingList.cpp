@@ -0,0 +1,347 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flattype/hash/PostingList.h"
+
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ftt {
+
+namespace {
+
+inline uint32_t bitWidth(uint32_t v) {
+  return v ? 32 - __builtin_clz(v) : 0;
+}
+
+void pack(const uint32_t* in, size_t n, uint32_t bits,
+          std::vector<uint32_t>& out) {
+  if (bits == 0) {
+    return;
+  }
+  size_t base = out.size();
+  out.resize(base + (n * bits + 31) / 32, 0);
+  for (size_t i = 0; i < n; i++) {
+    size_t pos = i * bits;
+    size_t w = base + pos / 32;
+    uint32_t sh = pos % 32;
+    out[w] |= in[i] << sh;
+    if (sh + bits > 32) {
+      out[w + 1] |= in[i] >> (32 - sh);
+    }
+  }
+}
+
+inline uint32_t unpack(const uint32_t* in, size_t i, uint32_t bits) {
+  size_t pos = i * bits;
+  const uint32_t* w = in + pos / 32;
+  uint32_t sh = pos % 32;
+  uint32_t v = w[0] >> sh;
+  if (sh + bits > 32) {
+    v |= w[1] << (32 - sh);
+  }
+  return bits < 32 ? v & ((uint32_t(1) << bits) - 1) : v;
+}
+
+inline bool lessBIndex(const BIndex& a, const BIndex& b) {
+  return a.block != b.block ? a.block < b.block : a.index < b.index;
+}
+
+} // namespace
+
+size_t PostingList::decodeChunk(size_t g, size_t c, uint32_t* out) const {
+  size_t first = groupChunk(g);
+  size_t len = std::min(groupSize(g) - (c - first) * kChunkSize,
+                        size_t(kChunkSize));
+  const uint32_t* ch = chunk(c);
+  const uint32_t* in = chunkData() + ch[2];
+  uint32_t bits = ch[1];
+  uint32_t v = ch[0];
+  out[0] = v;
+  if (bits == 0) {
+    for (size_t i = 1; i < len; i++) {
+      out[i] = ++v;
+    }
+  } else {
+    for (size_t i = 1; i < len; i++) {
+      v += unpack(in, i - 1, bits) + 1;
+      out[i] = v;
+    }
+  }
+  return len;
+}
+
+void PostingList::decodeGroup(size_t g, uint32_t* out) const {
+  for (size_t c = groupChunk(g), e = groupChunk(g + 1); c < e; c++) {
+    out += decodeChunk(g, c, out);
+  }
+}
+
+size_t PostingList::probeGroup(size_t g,
+                               const uint32_t* values, size_t n,
+                               uint32_t* out) const {
+  uint32_t buf[kChunkSize];
+  size_t m = 0;
+  size_t c = groupChunk(g), e = groupChunk(g + 1);
+  size_t loaded = e, len = 0, pos = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint32_t v = values[i];
+    while (c + 1 < e && chunk(c + 1)[0] <= v) {
+      c++;
+    }
+    if (chunk(c)[0] > v) {
+      continue;
+    }
+    if (c != loaded) {
+      len = decodeChunk(g, c, buf);
+      loaded = c;
+      pos = 0;
+    }
+    pos = std::lower_bound(buf + pos, buf + len, v) - buf;
+    if (pos < len && buf[pos] == v) {
+      out[m++] = v;
+    }
+  }
+  return m;
+}
+
+bool PostingList::contains(uint16_t block, uint32_t index) const {
+  size_t lo = 0, hi = groupCount();
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (groupBlock(mid) < block) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == groupCount() || groupBlock(lo) != block) {
+    return false;
+  }
+  // binary search the skip table for the last chunk whose first value is
+  // <= index, i.e. the one before the first chunk starting past index
+  size_t c = groupChunk(lo), e = groupChunk(lo + 1);
+  if (chunk(c)[0] > index) {
+    return false;
+  }
+  size_t l = c + 1, h = e;
+  while (l < h) {
+    size_t mid = (l + h) / 2;
+    if (chunk(mid)[0] <= index) {
+      l = mid + 1;
+    } else {
+      h = mid;
+    }
+  }
+  uint32_t buf[kChunkSize];
+  size_t len = decodeChunk(lo, l - 1, buf);
+  return std::binary_search(buf, buf + len, index);
+}
+
+std::vector<uint32_t> encodePostings(std::vector<BIndex> indexes) {
+  std::sort(indexes.begin(), indexes.end(), lessBIndex);
+  indexes.erase(
+      std::unique(indexes.begin(), indexes.end(),
+                  [](const BIndex& a, const BIndex& b) {
+                    return a.block == b.block && a.index == b.index;
+                  }),
+      indexes.end());
+
+  std::vector<uint32_t> groups, chunks, data;
+  uint32_t deltas[PostingList::kChunkSize];
+  for (size_t i = 0; i < indexes.size(); ) {
+    size_t j = i;
+    while (j < indexes.size() && indexes[j].block == indexes[i].block) {
+      j++;
+    }
+    groups.push_back(indexes[i].block);
+    groups.push_back(j - i);
+    groups.push_back(chunks.size() / 3);
+    for (size_t c = i; c < j; c += PostingList::kChunkSize) {
+      size_t len = std::min(j - c, size_t(PostingList::kChunkSize));
+      uint32_t bits = 0;
+      for (size_t k = 1; k < len; k++) {
+        deltas[k - 1] = indexes[c + k].index - indexes[c + k - 1].index - 1;
+        bits = std::max(bits, bitWidth(deltas[k - 1]));
+      }
+      chunks.push_back(indexes[c].index);
+      chunks.push_back(bits);
+      chunks.push_back(data.size());
+      pack(deltas, len - 1, bits, data);
+    }
+    i = j;
+  }
+
+  std::vector<uint32_t> out;
+  out.reserve(3 + groups.size() + chunks.size() + data.size());
+  out.push_back(indexes.size());
+  out.push_back(groups.size() / 3);
+  out.push_back(chunks.size() / 3);
+  out.insert(out.end(), groups.begin(), groups.end());
+  out.insert(out.end(), chunks.begin(), chunks.end());
+  out.insert(out.end(), data.begin(), data.end());
+  return out;
+}
+
+size_t intersectSorted(const uint32_t* a, size_t na,
+                       const uint32_t* b, size_t nb,
+                       uint32_t* out) {
+  if (na > nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  size_t n = 0, i = 0, j = 0;
+#if defined(__SSE2__)
+  for (; i < na && j + 4 <= nb; i++) {
+    while (j + 4 <= nb && b[j + 3] < a[i]) {
+      j += 4;
+    }
+    if (j + 4 > nb) {
+      break;
+    }
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+    __m128i x = _mm_set1_epi32(int(a[i]));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(v, x)) != 0) {
+      out[n++] = a[i];
+    }
+  }
+#endif
+  while (i < na && j < nb) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (b[j] < a[i]) {
+      j++;
+    } else {
+      out[n++] = a[i];
+      i++;
+      j++;
+    }
+  }
+  return n;
+}
+
+size_t uniteSorted(const uint32_t* a, size_t na,
+                   const uint32_t* b, size_t nb,
+                   uint32_t* out) {
+  size_t n = 0, i = 0, j = 0;
+  while (i < na && j < nb) {
+    uint32_t x = a[i], y = b[j];
+    out[n++] = std::min(x, y);
+    i += x <= y;
+    j += y <= x;
+  }
+  while (i < na) {
+    out[n++] = a[i++];
+  }
+  while (j < nb) {
+    out[n++] = b[j++];
+  }
+  return n;
+}
+
+std::vector<BIndex> intersectPostings(const std::vector<PostingList>& lists) {
+  std::vector<BIndex> result;
+  if (lists.empty()) {
+    return result;
+  }
+  // the shortest list drives, its blocks are looked up in the others
+  std::vector<const PostingList*> order;
+  for (auto& list : lists) {
+    order.push_back(&list);
+  }
+  std::sort(order.begin(), order.end(),
+            [](const PostingList* a, const PostingList* b) {
+              return a->size() < b->size();
+            });
+  std::vector<size_t> cursor(order.size(), 0);
+  std::vector<uint32_t> cur, next;
+  const PostingList& first = *order[0];
+  for (size_t g = 0; g < first.groupCount(); g++) {
+    uint16_t block = first.groupBlock(g);
+    cur.resize(first.groupSize(g));
+    first.decodeGroup(g, cur.data());
+    for (size_t k = 1; k < order.size() && !cur.empty(); k++) {
+      const PostingList& list = *order[k];
+      size_t& h = cursor[k];
+      while (h < list.groupCount() && list.groupBlock(h) < block) {
+        h++;
+      }
+      if (h == list.groupCount() || list.groupBlock(h) != block) {
+        cur.clear();
+        break;
+      }
+      size_t size = list.groupSize(h);
+      next.resize(std::min(cur.size(), size));
+      if (size / 32 > cur.size()) {
+        next.resize(list.probeGroup(h, cur.data(), cur.size(), next.data()));
+      } else {
+        std::vector<uint32_t> other(size);
+        list.decodeGroup(h, other.data());
+        next.resize(intersectSorted(cur.data(), cur.size(),
+                                    other.data(), size, next.data()));
+      }
+      cur.swap(next);
+    }
+    for (auto index : cur) {
+      result.push_back(BIndex{block, 0, index});
+    }
+  }
+  return result;
+}
+
+std::vector<BIndex> unitePostings(const std::vector<PostingList>& lists) {
+  std::vector<BIndex> result;
+  std::vector<size_t> cursor(lists.size(), 0);
+  std::vector<uint32_t> cur, next, other;
+  for (;;) {
+    // the smallest block not yet merged
+    bool found = false;
+    uint16_t block = 0;
+    for (size_t k = 0; k < lists.size(); k++) {
+      if (cursor[k] < lists[k].groupCount()) {
+        uint16_t b = lists[k].groupBlock(cursor[k]);
+        if (!found || b < block) {
+          block = b;
+          found = true;
+        }
+      }
+    }
+    if (!found) {
+      break;
+    }
+    cur.clear();
+    for (size_t k = 0; k < lists.size(); k++) {
+      size_t& g = cursor[k];
+      if (g < lists[k].groupCount() && lists[k].groupBlock(g) == block) {
+        other.resize(lists[k].groupSize(g));
+        lists[k].decodeGroup(g, other.data());
+        next.resize(cur.size() + other.size());
+        next.resize(uniteSorted(cur.data(), cur.size(),
+                                other.data(), other.size(), next.data()));
+        cur.swap(next);
+        g++;
+      }
+    }
+    for (auto index : cur) {
+      result.push_back(BIndex{block, 0, index});
+    }
+  }
+  return result;
+}
+
+} // namespace ftt
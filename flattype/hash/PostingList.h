@@ -0,0 +1,215 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "flattype/CommonIDLs.h"
+#include "flattype/hash/Slot.h"
+
+namespace ftt {
+
+/*
+ * Compressed list of slot indexes (the postings field of HSlot*). The
+ * (block, index) pairs of the BIndexes are grouped by block; the sorted
+ * index values of a group are cut into chunks of 128, each stored as its
+ * first value (the skip table) and the bit-packed deltas of the others.
+ * keep_ is not stored. All in one [uint] vector:
+ *
+ *   size, groups, chunks
+ *   groups x { block, count, first chunk }
+ *   chunks x { first value, bit width, data offset }
+ *   data
+ */
+class PostingList {
+ public:
+  enum : size_t {
+    kChunkSize = 128,
+  };
+
+  typedef struct ConstIterator {
+    ConstIterator()
+      : list_(nullptr) {}
+    ConstIterator(const PostingList& list, size_t group)
+      : list_(&list),
+        group_(group) {
+      load();
+    }
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    BIndex operator*() const {
+      return BIndex{block_, 0, buf_[pos_]};
+    }
+
+    const ConstIterator& operator++() {
+      if (++pos_ == len_) {
+        if (++chunk_ == chunkEnd_) {
+          ++group_;
+          load();
+        } else {
+          len_ = list_->decodeChunk(group_, chunk_, buf_);
+          pos_ = 0;
+        }
+      }
+      return *this;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return group_ == rhs.group_ && pos_ == rhs.pos_ && chunk_ == rhs.chunk_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    void load() {
+      chunk_ = pos_ = 0;
+      if (group_ < list_->groupCount()) {
+        block_ = list_->groupBlock(group_);
+        chunk_ = list_->groupChunk(group_);
+        chunkEnd_ = list_->groupChunk(group_ + 1);
+        len_ = list_->decodeChunk(group_, chunk_, buf_);
+      } else {
+        group_ = list_->groupCount();
+      }
+    }
+
+    const PostingList* list_;
+    size_t group_{0};
+    size_t chunk_{0};
+    size_t chunkEnd_{0};
+    size_t pos_{0};
+    size_t len_{0};
+    uint16_t block_{0};
+    uint32_t buf_[kChunkSize];
+  } const_iterator;
+
+ public:
+  PostingList() {}
+  explicit PostingList(const ::flatbuffers::Vector<uint32_t>* data)
+    : data_(data && data->size() >= 3 ? data->data() : nullptr) {}
+  explicit PostingList(const uint32_t* data)
+    : data_(data) {}
+
+  // the index list of a slot, empty if written without one
+  template <class S>
+  static PostingList of(const S* slot) {
+    return PostingList(slot->postings());
+  }
+
+  explicit operator bool() const {
+    return data_ != nullptr;
+  }
+
+  size_t size() const {
+    return data_ ? data_[0] : 0;
+  }
+
+  size_t groupCount() const {
+    return data_ ? data_[1] : 0;
+  }
+  uint16_t groupBlock(size_t g) const {
+    return uint16_t(group(g)[0]);
+  }
+  size_t groupSize(size_t g) const {
+    return group(g)[1];
+  }
+
+  // decode the sorted index values of group g into out (groupSize(g))
+  void decodeGroup(size_t g, uint32_t* out) const;
+
+  // intersect n sorted values with group g, decoding only the chunks the
+  // skip table finds for them; returns the size of out
+  size_t probeGroup(size_t g, const uint32_t* values, size_t n,
+                    uint32_t* out) const;
+
+  bool contains(uint16_t block, uint32_t index) const;
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+  const_iterator cend() const {
+    return ConstIterator(*this, groupCount());
+  }
+
+ private:
+  friend struct ConstIterator;
+
+  const uint32_t* group(size_t g) const {
+    return data_ + 3 + g * 3;
+  }
+  const uint32_t* chunk(size_t c) const {
+    return data_ + 3 + data_[1] * 3 + c * 3;
+  }
+  const uint32_t* chunkData() const {
+    return data_ + 3 + data_[1] * 3 + data_[2] * 3;
+  }
+
+  // first chunk of group g, g may be groupCount()
+  size_t groupChunk(size_t g) const {
+    return g < groupCount() ? group(g)[2] : data_[2];
+  }
+
+  // decode chunk c of group g into out, returns the number of values
+  size_t decodeChunk(size_t g, size_t c, uint32_t* out) const;
+
+  const uint32_t* data_{nullptr};
+};
+
+/*
+ * Call f(BIndex) for the indexes of a slot: its postings if it has them,
+ * or else its indexes. Unlike forEachIndex() f is called directly, not
+ * through a std::function.
+ */
+template <class S, class F>
+void visitIndexes(const S* slot, F&& f) {
+  PostingList list = PostingList::of(slot);
+  if (list) {
+    for (auto it = list.cbegin(), end = list.cend(); it != end; ++it) {
+      f(*it);
+    }
+  } else if (slot->indexes()) {
+    for (uint64_t i : *slot->indexes()) {
+      f(u64ToBIndex(i));
+    }
+  }
+}
+
+// encode indexes into a PostingList, repeated (block, index) pairs once
+std::vector<uint32_t> encodePostings(std::vector<BIndex> indexes);
+
+/*
+ * Sets of sorted uint32 values, out must hold min(na, nb) values for the
+ * intersection, na + nb for the union; both return the size of out. The
+ * intersection compares 4 values at a time with SSE2 when available.
+ */
+size_t intersectSorted(const uint32_t* a, size_t na,
+                       const uint32_t* b, size_t nb,
+                       uint32_t* out);
+size_t uniteSorted(const uint32_t* a, size_t na,
+                   const uint32_t* b, size_t nb,
+                   uint32_t* out);
+
+// the indexes in all of lists (AND) or in any of them (OR), sorted by
+// block and index
+std::vector<BIndex> intersectPostings(const std::vector<PostingList>& lists);
+std::vector<BIndex> unitePostings(const std::vector<PostingList>& lists);
+
+} // namespace ftt
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "flattype/CommonIDLs.h"
+#include "flattype/hash/Hash.h"
+#include "flattype/hash/HashMap.h"
+
+namespace ftt {
+
+template <class FT>
+struct ShardTraits;
+
+template <>
+struct ShardTraits<fbs::HShards32> {
+  typedef HashMap32 map_type;
+};
+
+template <>
+struct ShardTraits<fbs::HShards64> {
+  typedef HashMap64 map_type;
+};
+
+template <>
+struct ShardTraits<fbs::HShardsS> {
+  typedef HashMapS map_type;
+};
+
+enum : unsigned {
+  kMaxShardBits = 16,
+};
+
+// bits 32..47 of the hash, which the slot index (the low 32 bits at most)
+// and the fingerprint (the top 16 bits) of a shard do not use
+inline size_t hashToShard(uint64_t hash, unsigned bits) {
+  return size_t((hash >> 32) & ((uint64_t(1) << bits) - 1));
+}
+
+/*
+ * A chained map split into 2^bits shards by the key hash (hashToShard()).
+ * Each shard is a HashMap of its own with 32-bit slot indexes, a lookup
+ * hashes the key once to pick the shard and then its bucket. With up to
+ * 2^16 shards of 2^30 slots the map holds far more than 2^32 keys.
+ *
+ * Shards stored apart are attached with setShard(), they may be loaded
+ * and queried one by one. Looking up a key of a shard not loaded throws
+ * std::runtime_error, iteration skips such shards.
+ */
+template <class FT>
+class ShardedHashMapBase {
+ public:
+  typedef FT ft_type;
+  typedef typename ShardTraits<FT>::map_type map_type;
+  typedef typename map_type::value_type value_type;
+  typedef typename map_type::key_type key_type;
+  typedef typename map_type::const_iterator map_iterator;
+
+  typedef struct ConstIterator {
+    ConstIterator()
+      : owner_(nullptr),
+        shard_(0) {}
+    ConstIterator(const ShardedHashMapBase& owner,
+                  size_t shard,
+                  map_iterator it)
+      : owner_(&owner),
+        shard_(shard),
+        it_(it) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return *it_;
+    }
+    const value_type* operator->() const {
+      return it_.operator->();
+    }
+
+    const ConstIterator& operator++() {
+      ++it_;
+      skipEmpty();
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return shard_ == rhs.shard_ && it_ == rhs.it_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    friend class ShardedHashMapBase;
+
+    // move to the next entry of a loaded shard
+    void skipEmpty() {
+      auto& shards = owner_->shards_;
+      while (shard_ < shards.size() &&
+             (!shards[shard_] || it_ == shards[shard_]->cend())) {
+        it_ = ++shard_ < shards.size() && shards[shard_]
+          ? shards[shard_]->cbegin()
+          : map_iterator();
+      }
+    }
+
+    const ShardedHashMapBase* owner_;
+    size_t shard_;
+    map_iterator it_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  ShardedHashMapBase(const FT* hmap)
+    : ptr_(hmap) {
+    if (ptr_) {
+      bits_ = ptr_->bits();
+      if (bits_ > kMaxShardBits) {
+        throw std::invalid_argument("HashMap shard bits must be at most 16");
+      }
+      auto shards = ptr_->shards();
+      if (shards->size() != (size_t(1) << bits_)) {
+        throw std::invalid_argument("HashMap must have 2^bits shards");
+      }
+      shards_.resize(shards->size());
+      for (size_t i = 0; i < shards->size(); i++) {
+        auto shard = shards->Get(i);
+        if (shard->data()) {
+          setShard(i, shard->data()->data());
+        }
+        size_ += shard->size();
+      }
+    }
+  }
+
+  explicit ShardedHashMapBase(const uint8_t* data)
+    : ShardedHashMapBase(
+        data ? ::flatbuffers::GetRoot<FT>(data) : nullptr) {}
+  explicit ShardedHashMapBase(::flatbuffers::DetachedBuffer&& data)
+    : ShardedHashMapBase(data.data()) {
+    data_ = std::move(data);
+  }
+
+  ShardedHashMapBase(const ShardedHashMapBase&) = delete;
+  ShardedHashMapBase& operator=(const ShardedHashMapBase&) = delete;
+
+  ShardedHashMapBase(ShardedHashMapBase&&) = default;
+  ShardedHashMapBase& operator=(ShardedHashMapBase&&) = default;
+
+  unsigned getBits() const {
+    return bits_;
+  }
+
+  size_t shardCount() const {
+    return shards_.size();
+  }
+
+  // the number of keys in all the shards, loaded or not
+  uint64_t size() const {
+    return size_;
+  }
+
+  // the positions forEachRange() visits, those of the loaded shards one
+  // after another
+  size_t scanSize() const {
+    size_t n = 0;
+    for (auto& shard : shards_) {
+      n += shard ? shard->scanSize() : 0;
+    }
+    return n;
+  }
+
+  // call f(const value_type&) for the keys at positions [begin, end),
+  // disjoint ranges may be visited by several threads at the same time
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    size_t base = 0;
+    for (auto& shard : shards_) {
+      if (base >= end) {
+        break;
+      }
+      if (shard) {
+        size_t n = shard->scanSize();
+        if (begin < base + n) {
+          shard->forEachRange(begin > base ? begin - base : 0,
+                              end - base, f);
+        }
+        base += n;
+      }
+    }
+  }
+
+  bool hasShard(size_t i) const {
+    return shards_[i] != nullptr;
+  }
+
+  const map_type& getShard(size_t i) const {
+    return *shards_[i];
+  }
+
+  // attach shard i, a finished HMap32/64/S buffer
+  void setShard(size_t i, const uint8_t* data) {
+    attach(i, new map_type(data));
+  }
+  void setShard(size_t i, ::flatbuffers::DetachedBuffer&& data) {
+    attach(i, new map_type(std::move(data)));
+  }
+
+  void unsetShard(size_t i) {
+    shards_[i].reset();
+  }
+
+  const_iterator find(const key_type& key) const {
+    return find(key, hashKey(key));
+  }
+
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  const_iterator cbegin() const {
+    ConstIterator it(*this, 0,
+                     !shards_.empty() && shards_[0] ? shards_[0]->cbegin()
+                                                    : map_iterator());
+    it.skipEmpty();
+    return it;
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, shards_.size(), map_iterator());
+  }
+
+ private:
+  const_iterator find(const key_type& key, uint64_t hash) const {
+    if (shards_.empty()) {
+      return cend();
+    }
+    size_t s = hashToShard(hash, bits_);
+    auto& shard = shards_[s];
+    if (!shard) {
+      throw std::runtime_error("HashMap shard is not loaded");
+    }
+    auto it = shard->findWithHash(key, hash);
+    return it != shard->cend() ? ConstIterator(*this, s, it) : cend();
+  }
+
+  void attach(size_t i, map_type* shard) {
+    std::unique_ptr<map_type> p(shard);
+    if (i >= shards_.size()) {
+      throw std::out_of_range("HashMap shard index out of range");
+    }
+    if (p->getHashType() != fbs::HashType::Murmur) {
+      throw std::invalid_argument("HashMap shard must use the Murmur hash");
+    }
+    shards_[i] = std::move(p);
+  }
+
+  const FT* ptr_{nullptr};
+  unsigned bits_{0};
+  uint64_t size_{0};
+  std::vector<std::unique_ptr<map_type>> shards_;
+  ::flatbuffers::DetachedBuffer data_;
+};
+
+typedef ShardedHashMapBase<fbs::HShards32> ShardedHashMap32;
+typedef ShardedHashMapBase<fbs::HShards64> ShardedHashMap64;
+typedef ShardedHashMapBase<fbs::HShardsS>  ShardedHashMapS;
+
+} // namespace ftt
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+#include "flattype/Builder.h"
+#include "flattype/hash/HashMapBuilder.h"
+#include "flattype/hash/ShardedHashMap.h"
+
+namespace ftt {
+
+template <class FT>
+struct ShardBuilderTraits;
+
+template <>
+struct ShardBuilderTraits<fbs::HShards32> {
+  typedef HashMap32Builder builder_type;
+
+  static ::flatbuffers::Offset<fbs::HShards32> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      unsigned bits,
+      const std::vector<::flatbuffers::Offset<fbs::HShard>>* shards) {
+    return fbs::CreateHShards32Direct(fbb, bits, shards);
+  }
+};
+
+template <>
+struct ShardBuilderTraits<fbs::HShards64> {
+  typedef HashMap64Builder builder_type;
+
+  static ::flatbuffers::Offset<fbs::HShards64> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      unsigned bits,
+      const std::vector<::flatbuffers::Offset<fbs::HShard>>* shards) {
+    return fbs::CreateHShards64Direct(fbb, bits, shards);
+  }
+};
+
+template <>
+struct ShardBuilderTraits<fbs::HShardsS> {
+  typedef HashMapSBuilder builder_type;
+
+  static ::flatbuffers::Offset<fbs::HShardsS> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      unsigned bits,
+      const std::vector<::flatbuffers::Offset<fbs::HShard>>* shards) {
+    return fbs::CreateHShardsSDirect(fbb, bits, shards);
+  }
+};
+
+/*
+ * Builds a sharded map in parallel: the entries are partitioned by
+ * hashToShard() and every shard is bulk built (HashMapBuilderBase::build)
+ * into an FBB of its own on a pool of threads. The finished shard buffers
+ * are copied into the directory once on finish().
+ *
+ * Shards can also be built one at a time with buildShard(), and taken out
+ * with detachShard() to be stored apart when the whole map is too large
+ * for a single buffer.
+ */
+template <class FT>
+class ShardedHashMapBuilderBase : public Builder {
+ public:
+  typedef ShardBuilderTraits<FT> traits_type;
+  typedef typename traits_type::builder_type shard_builder_type;
+  typedef typename shard_builder_type::native_type native_type;
+
+ public:
+  explicit ShardedHashMapBuilderBase(unsigned bits)
+    : Builder() {
+    init(bits);
+  }
+
+  ShardedHashMapBuilderBase(unsigned bits, FBB* fbb, bool owns = false)
+    : Builder(fbb, owns) {
+    init(bits);
+  }
+
+  void init(unsigned bits) {
+    if (bits > kMaxShardBits) {
+      throw std::invalid_argument("HashMap shard bits must be at most 16");
+    }
+    bits_ = bits;
+    shards_.clear();
+    shards_.resize(size_t(1) << bits);
+  }
+
+  ShardedHashMapBuilderBase(const ShardedHashMapBuilderBase&) = delete;
+  ShardedHashMapBuilderBase& operator=(
+      const ShardedHashMapBuilderBase&) = delete;
+
+  ShardedHashMapBuilderBase(ShardedHashMapBuilderBase&&) = default;
+  ShardedHashMapBuilderBase& operator=(ShardedHashMapBuilderBase&&) = default;
+
+  unsigned getBits() const {
+    return bits_;
+  }
+
+  /*
+   * Partition the entries by hashToShard() and build all the shards, on
+   * `threads` threads.
+   */
+  void build(std::vector<native_type>&& entries,
+             size_t threads = 1,
+             float loadFactor = 0.95f) {
+    size_t n = shards_.size();
+    for (size_t s = 0; s < n; s++) {
+      checkShard(s);
+    }
+    std::vector<std::vector<native_type>> parts(n);
+    if (n == 1) {
+      parts[0] = std::move(entries);
+    } else {
+      std::vector<uint32_t> shard(entries.size());
+      std::vector<size_t> count(n, 0);
+      for (size_t i = 0; i < entries.size(); i++) {
+        shard[i] = hashToShard(hashKey(entries[i].key), bits_);
+        count[shard[i]]++;
+      }
+      for (size_t s = 0; s < n; s++) {
+        parts[s].reserve(count[s]);
+      }
+      for (size_t i = 0; i < entries.size(); i++) {
+        parts[shard[i]].push_back(std::move(entries[i]));
+      }
+      entries.clear();
+    }
+
+    threads = std::max(std::min(threads, n), size_t(1));
+    std::vector<std::exception_ptr> errors(threads);
+    auto worker = [&](size_t t) {
+      try {
+        for (size_t s = t; s < n; s += threads) {
+          buildPart(s, std::move(parts[s]), loadFactor);
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    };
+
+    if (threads == 1) {
+      worker(0);
+    } else {
+      std::vector<std::thread> pool;
+      for (size_t t = 0; t < threads; t++) {
+        pool.emplace_back(worker, t);
+      }
+      for (auto& th : pool) {
+        th.join();
+      }
+    }
+    for (auto& e : errors) {
+      if (e) {
+        std::rethrow_exception(e);
+      }
+    }
+  }
+
+  // build shard i alone, every entry must go to shard i
+  void buildShard(size_t i,
+                  std::vector<native_type>&& entries,
+                  float loadFactor = 0.95f) {
+    checkShard(i);
+    for (auto& entry : entries) {
+      if (hashToShard(hashKey(entry.key), bits_) != i) {
+        throw std::invalid_argument("HashMap entry is not of the shard");
+      }
+    }
+    buildPart(i, std::move(entries), loadFactor);
+  }
+
+  /*
+   * Take the finished buffer of shard i (an empty map if not built), to
+   * store it apart; the directory then records shard i without its data,
+   * see ShardedHashMapBase::setShard().
+   */
+  ::flatbuffers::DetachedBuffer detachShard(size_t i) {
+    checkShard(i);
+    auto& shard = shards_[i];
+    if (shard.data.size() == 0) {
+      buildPart(i, std::vector<native_type>(), 0.95f);
+    }
+    shard.external = true;
+    return std::move(shard.data);
+  }
+
+  // the number of keys in all the shards
+  uint64_t size() const {
+    uint64_t n = 0;
+    for (auto& shard : shards_) {
+      n += shard.size;
+    }
+    return n;
+  }
+
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  ::flatbuffers::Offset<FT> create() {
+    std::vector<::flatbuffers::Offset<fbs::HShard>> shards;
+    shards.reserve(shards_.size());
+    for (size_t i = 0; i < shards_.size(); i++) {
+      auto& shard = shards_[i];
+      ::flatbuffers::Offset<::flatbuffers::Vector<uint8_t>> data;
+      if (!shard.external) {
+        if (shard.data.size() == 0) {
+          buildPart(i, std::vector<native_type>(), 0.95f);
+        }
+        fbb_->ForceVectorAlignment(shard.data.size(), 1, kShardAlignment);
+        data = fbb_->CreateVector(shard.data.data(), shard.data.size());
+      }
+      shards.push_back(fbs::CreateHShard(*fbb_, data, shard.size));
+    }
+    return traits_type::create(*fbb_, bits_, &shards);
+  }
+
+  void finish() override {
+    if (finished_) {
+      return;
+    }
+    fbb_->Finish(create());
+    data_ = fbb_->Release();
+    finished_ = true;
+  }
+
+ private:
+  enum : size_t {
+    kShardAlignment = 8,
+  };
+
+  struct Shard {
+    ::flatbuffers::DetachedBuffer data;
+    uint64_t size{0};
+    bool external{false};
+  };
+
+  void checkShard(size_t i) const {
+    if (i >= shards_.size()) {
+      throw std::out_of_range("HashMap shard index out of range");
+    }
+    if (shards_[i].external) {
+      throw std::runtime_error("HashMap shard is detached");
+    }
+  }
+
+  // safe to call for distinct shards at the same time
+  void buildPart(size_t i,
+                 std::vector<native_type>&& entries,
+                 float loadFactor) {
+    shard_builder_type builder(0);
+    builder.build(std::move(entries), loadFactor);
+    builder.finish();
+    shards_[i].data = builder.detachedData();
+    shards_[i].size = builder.size();
+  }
+
+  unsigned bits_{0};
+  std::vector<Shard> shards_;
+};
+
+class ShardedHashMap32Builder
+  : public ShardedHashMapBuilderBase<fbs::HShards32> {
+ public:
+  explicit ShardedHashMap32Builder(unsigned bits)
+    : ShardedHashMapBuilderBase(bits) {}
+  ShardedHashMap32Builder(unsigned bits, FBB* fbb, bool owns = false)
+    : ShardedHashMapBuilderBase(bits, fbb, owns) {}
+
+  ShardedHashMap32 toHashMap() { return toWrapper<ShardedHashMap32>(); }
+};
+
+class ShardedHashMap64Builder
+  : public ShardedHashMapBuilderBase<fbs::HShards64> {
+ public:
+  explicit ShardedHashMap64Builder(unsigned bits)
+    : ShardedHashMapBuilderBase(bits) {}
+  ShardedHashMap64Builder(unsigned bits, FBB* fbb, bool owns = false)
+    : ShardedHashMapBuilderBase(bits, fbb, owns) {}
+
+  ShardedHashMap64 toHashMap() { return toWrapper<ShardedHashMap64>(); }
+};
+
+class ShardedHashMapSBuilder
+  : public ShardedHashMapBuilderBase<fbs::HShardsS> {
+ public:
+  explicit ShardedHashMapSBuilder(unsigned bits)
+    : ShardedHashMapBuilderBase(bits) {}
+  ShardedHashMapSBuilder(unsigned bits, FBB* fbb, bool owns = false)
+    : ShardedHashMapBuilderBase(bits, fbb, owns) {}
+
+  ShardedHashMapS toHashMap() { return toWrapper<ShardedHashMapS>(); }
+};
+
+} // namespace ftt
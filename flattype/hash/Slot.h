@@ -16,8 +16,14 @@
 
 #pragma once
 
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#include "accelerator/Range.h"
 #include "flattype/CommonIDLs.h"
 #include "flattype/Encoding.h"
+#include "flattype/hash/Hash.h"
 
 namespace ftt {
 
@@ -53,9 +59,131 @@ struct SlotIndexType;
 template <> struct SlotIndexType<fbs::HSlot32> { using type = uint32_t; };
 template <> struct SlotIndexType<fbs::HSlot64> { using type = uint64_t; };
 template <> struct SlotIndexType<fbs::HSlotS>  {
-  using type = ::flatbuffers::String*;
+  using type = acc::StringPiece;
 };
 
+// key type of the builders (the native table key)
+template <class T>
+struct SlotKeyType;
+
+template <> struct SlotKeyType<fbs::HSlot32> { using type = uint32_t; };
+template <> struct SlotKeyType<fbs::HSlot64> { using type = uint64_t; };
+template <> struct SlotKeyType<fbs::HSlotS>  { using type = std::string; };
+
+// Hash of the chained maps, see HashType in idl/hash.fbs.
+inline uint64_t legacyHash(uint32_t key) {
+  return std::hash<uint32_t>()(key);
+}
+inline uint64_t legacyHash(uint64_t key) {
+  return std::hash<uint64_t>()(key);
+}
+inline uint64_t legacyHash(acc::StringPiece key) {
+  return hashKey(key);
+}
+
+template <class K>
+inline uint64_t slotHash(fbs::HashType type, const K& key) {
+  return type == fbs::HashType::Murmur ? hashKey(key) : legacyHash(key);
+}
+
+// 16 bits of the hash not used for the slot index, never 0 so that 0 can
+// stand for slots written without a fingerprint
+inline uint16_t slotFingerprint(uint64_t hash) {
+  uint16_t fp = uint16_t(hash >> 48);
+  return fp != 0 ? fp : 1;
+}
+
+// the Legacy hash of an integer is the integer itself, whose top bits are
+// 0 below 2^48, so its fingerprint is taken from the mixed hash
+inline uint16_t slotFingerprint(fbs::HashType type, uint64_t hash) {
+  return slotFingerprint(type == fbs::HashType::Murmur ? hash
+                                                       : hashInt(hash));
+}
+
+inline bool keyEquals(uint32_t a, uint32_t b) {
+  return a == b;
+}
+inline bool keyEquals(uint64_t a, uint64_t b) {
+  return a == b;
+}
+inline bool keyEquals(const ::flatbuffers::String* a, acc::StringPiece b) {
+  return a && acc::StringPiece(a->data(), a->size()) == b;
+}
+inline bool keyEquals(const ::flatbuffers::String* a,
+                      const ::flatbuffers::String* b) {
+  return b && keyEquals(a, acc::StringPiece(b->data(), b->size()));
+}
+
+// Scalar values may be stored inline in the slot (scalar and scalar_type)
+// instead of as a table of the value union, saving an indirection per
+// lookup and the table per slot.
+
+inline uint64_t scalarToBits(bool value) {
+  return value ? 1 : 0;
+}
+inline uint64_t scalarToBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+inline uint64_t scalarToBits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+template <class T>
+inline typename std::enable_if<
+  std::is_integral<T>::value && !std::is_same<T, bool>::value, uint64_t>::type
+scalarToBits(T value) {
+  return uint64_t(value);
+}
+
+inline void scalarFromBits(uint64_t bits, bool& value) {
+  value = bits != 0;
+}
+inline void scalarFromBits(uint64_t bits, float& value) {
+  uint32_t b = uint32_t(bits);
+  memcpy(&value, &b, sizeof(value));
+}
+inline void scalarFromBits(uint64_t bits, double& value) {
+  memcpy(&value, &bits, sizeof(value));
+}
+template <class T>
+inline typename std::enable_if<
+  std::is_integral<T>::value && !std::is_same<T, bool>::value>::type
+scalarFromBits(uint64_t bits, T& value) {
+  value = T(bits);
+}
+
+// store value inline in a native slot (HSlot32T, HSlot64T or HSlotST)
+template <class NT, class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value>::type
+setInlineValue(NT& slot, T value) {
+  slot.scalar = scalarToBits(value);
+  slot.scalar_type = uint8_t(getAnyType<T>());
+}
+
+template <class S>
+inline bool hasInlineValue(const S* slot) {
+  return slot->scalar_type() != uint8_t(fbs::Any::NONE);
+}
+
+template <class T, class S>
+inline typename std::enable_if<std::is_arithmetic<T>::value, bool>::type
+decodeInline(const S* slot, T& value) {
+  if (slot->scalar_type() != uint8_t(getAnyType<T>())) {
+    return false;
+  }
+  scalarFromBits(slot->scalar(), value);
+  return true;
+}
+template <class T, class S>
+inline typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type
+decodeInline(const S*, T&) {
+  return false;
+}
+
+// reads an inline scalar if there is one, the value union otherwise
 template <class T, class S>
 inline typename std::enable_if<
   std::is_same<S, fbs::HSlot32>::value ||
@@ -63,6 +191,9 @@ inline typename std::enable_if<
   std::is_same<S, fbs::HSlotS>::value
   >::type
 decode(const S* slot, T& value) {
+  if (decodeInline(slot, value)) {
+    return;
+  }
   assert(slot->value_type() == getAnyType<T>());
   decode(slot->value(), value);
 }
@@ -74,6 +205,9 @@ inline typename std::enable_if<
   std::is_same<S, fbs::HSlotS>::value
   >::type
 forEachIndex(const S* slot, const std::function<void(BIndex)>& func) {
+  if (!slot->indexes()) {
+    return;
+  }
   for (uint64_t i : *slot->indexes()) {
     func(u64ToBIndex(i));
   }
@@ -100,6 +234,13 @@ struct SlotState {
   static uint32_t next(const FT* slot) {
     return slot ? slot->next() : 0;
   }
+
+  // a candidate for the key with fingerprint fp
+  template <class FT>
+  static bool matches(const FT* slot, uint16_t fp) {
+    uint16_t f = slot->fp();
+    return f == 0 || f == fp;
+  }
 };
 
 } // namespace ftt
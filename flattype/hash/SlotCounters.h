@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdexcept>
+
+#include "flattype/CommonIDLs.h"
+
+namespace ftt {
+
+/*
+ * The counter column of a HashMap written with setCounterColumns(): a
+ * fixed number of 64-bit words per slot, addressed by slot id (see
+ * HashMapBase::ConstIterator::slot()), updated in place on a writable
+ * mapping of the map, e.g. a MAP_SHARED mmap or the buffer of a builder.
+ *
+ * The words are accessed with atomic builtins, so several threads (or
+ * processes sharing the mapping) may update counters concurrently without
+ * locks and without rebuilding the map. Operations are relaxed: counters
+ * are not ordered with respect to other memory.
+ */
+template <class FT>
+class SlotCountersBase {
+ public:
+  static_assert(FLATBUFFERS_LITTLEENDIAN,
+                "in-place counters need the flatbuffers byte order");
+
+  explicit SlotCountersBase(uint8_t* data) {
+    auto hmap = ::flatbuffers::GetMutableRoot<FT>(data);
+    auto counters = hmap->mutable_counters();
+    columns_ = hmap->columns();
+    if (!counters || columns_ == 0) {
+      throw std::runtime_error("HashMap has no counter columns");
+    }
+    numSlots_ = hmap->slots()->size();
+    if (counters->size() != numSlots_ * columns_) {
+      throw std::runtime_error("HashMap counter column size mismatch");
+    }
+    words_ = reinterpret_cast<uint64_t*>(counters->Data());
+    if (reinterpret_cast<uintptr_t>(words_) % sizeof(uint64_t) != 0) {
+      throw std::runtime_error("HashMap counters are not 8-byte aligned");
+    }
+  }
+
+  size_t columns() const {
+    return columns_;
+  }
+
+  uint64_t load(uint32_t slot, size_t column = 0) const {
+    return __atomic_load_n(word(slot, column), __ATOMIC_RELAXED);
+  }
+
+  void store(uint32_t slot, size_t column, uint64_t value) {
+    __atomic_store_n(word(slot, column), value, __ATOMIC_RELAXED);
+  }
+
+  // returns the value before the addition
+  uint64_t fetchAdd(uint32_t slot, size_t column, uint64_t delta) {
+    return __atomic_fetch_add(word(slot, column), delta, __ATOMIC_RELAXED);
+  }
+
+  // store value if it is greater than the current one, e.g. a last-seen
+  // time, returns the value before
+  uint64_t fetchMax(uint32_t slot, size_t column, uint64_t value) {
+    uint64_t* p = word(slot, column);
+    uint64_t prev = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (prev < value &&
+           !__atomic_compare_exchange_n(p, &prev, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return prev;
+  }
+
+ private:
+  uint64_t* word(uint32_t slot, size_t column) const {
+    if (slot >= numSlots_ || column >= columns_) {
+      throw std::out_of_range("HashMap counter out of range");
+    }
+    return words_ + size_t(slot) * columns_ + column;
+  }
+
+  uint64_t* words_;
+  size_t numSlots_;
+  size_t columns_;
+};
+
+typedef SlotCountersBase<fbs::HMap32> SlotCounters32;
+typedef SlotCountersBase<fbs::HMap64> SlotCounters64;
+typedef SlotCountersBase<fbs::HMapS>  SlotCountersS;
+
+} // namespace ftt
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "accelerator/Range.h"
+#include "flattype/CommonIDLs.h"
+#include "flattype/Util.h"
+#include "flattype/hash/Hash.h"
+#include "flattype/hash/Slot.h"
+
+namespace ftt {
+
+namespace detail {
+
+enum : uint8_t {
+  kSwissEmpty = 0x80,
+};
+
+enum : size_t {
+  kSwissGroupSize = 16,
+};
+
+inline uint8_t swissTag(uint64_t hash) {
+  return uint8_t(hash & 0x7f);
+}
+
+// bit i is set if byte i of the 16-byte group equals value
+inline uint32_t swissMatch(const uint8_t* group, uint8_t value) {
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return uint32_t(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(char(value)))));
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kSwissGroupSize; i++) {
+    mask |= uint32_t(group[i] == value) << i;
+  }
+  return mask;
+#endif
+}
+
+/*
+ * The slot holding a key equal to eq(slot), or -1. The table must have an
+ * empty slot, which ends the probe of a missing key.
+ */
+template <class Eq>
+inline size_t swissFind(const uint8_t* ctrl,
+                        size_t groupMask,
+                        uint64_t hash,
+                        const Eq& eq) {
+  uint8_t tag = swissTag(hash);
+  size_t g = (hash >> 7) & groupMask;
+  for (size_t i = 1; ; i++) {
+    const uint8_t* group = ctrl + g * kSwissGroupSize;
+    for (uint32_t m = swissMatch(group, tag); m != 0; m &= m - 1) {
+      size_t slot = g * kSwissGroupSize + __builtin_ctz(m);
+      if (eq(slot)) {
+        return slot;
+      }
+    }
+    if (swissMatch(group, kSwissEmpty) != 0) {
+      return size_t(-1);
+    }
+    g = (g + i) & groupMask;
+  }
+}
+
+// the first empty slot on the probe sequence of hash
+inline size_t swissFindEmpty(const uint8_t* ctrl,
+                             size_t groupMask,
+                             uint64_t hash) {
+  size_t g = (hash >> 7) & groupMask;
+  for (size_t i = 1; ; i++) {
+    uint32_t m = swissMatch(ctrl + g * kSwissGroupSize, kSwissEmpty);
+    if (m != 0) {
+      return g * kSwissGroupSize + __builtin_ctz(m);
+    }
+    g = (g + i) & groupMask;
+  }
+}
+
+} // namespace detail
+
+template <class S>
+struct SwissSlotTraits;
+
+template <>
+struct SwissSlotTraits<fbs::HSlot32> {
+  typedef fbs::SHMap32 map_type;
+  typedef uint32_t key_type;
+  typedef uint32_t native_key_type;
+
+  static bool match(const map_type* hmap, size_t slot, key_type key) {
+    return hmap->keys()->Get(slot) == key;
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<uint8_t>& ctrl,
+      const std::vector<uint32_t>& slots,
+      const std::vector<fbs::HSlot32T>& objs,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot32>>& entries) {
+    std::vector<uint32_t> keys(slots.size());
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (ctrl[i] != detail::kSwissEmpty) {
+        keys[i] = objs[slots[i]].key;
+      }
+    }
+    fbb.ForceVectorAlignment(ctrl.size(), 1, detail::kSwissGroupSize);
+    return fbs::CreateSHMap32Direct(fbb, &ctrl, &keys, &slots, &entries);
+  }
+};
+
+template <>
+struct SwissSlotTraits<fbs::HSlot64> {
+  typedef fbs::SHMap64 map_type;
+  typedef uint64_t key_type;
+  typedef uint64_t native_key_type;
+
+  static bool match(const map_type* hmap, size_t slot, key_type key) {
+    return hmap->keys()->Get(slot) == key;
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<uint8_t>& ctrl,
+      const std::vector<uint32_t>& slots,
+      const std::vector<fbs::HSlot64T>& objs,
+      const std::vector<::flatbuffers::Offset<fbs::HSlot64>>& entries) {
+    std::vector<uint64_t> keys(slots.size());
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (ctrl[i] != detail::kSwissEmpty) {
+        keys[i] = objs[slots[i]].key;
+      }
+    }
+    fbb.ForceVectorAlignment(ctrl.size(), 1, detail::kSwissGroupSize);
+    return fbs::CreateSHMap64Direct(fbb, &ctrl, &keys, &slots, &entries);
+  }
+};
+
+template <>
+struct SwissSlotTraits<fbs::HSlotS> {
+  typedef fbs::SHMapS map_type;
+  typedef acc::StringPiece key_type;
+  typedef std::string native_key_type;
+
+  static bool match(const map_type* hmap, size_t slot, key_type key) {
+    auto entry = hmap->entries()->Get(hmap->slots()->Get(slot));
+    return keyEquals(entry->key(), key);
+  }
+
+  static ::flatbuffers::Offset<map_type> create(
+      ::flatbuffers::FlatBufferBuilder& fbb,
+      const std::vector<uint8_t>& ctrl,
+      const std::vector<uint32_t>& slots,
+      const std::vector<fbs::HSlotST>&,
+      const std::vector<::flatbuffers::Offset<fbs::HSlotS>>& entries) {
+    fbb.ForceVectorAlignment(ctrl.size(), 1, detail::kSwissGroupSize);
+    return fbs::CreateSHMapSDirect(fbb, &ctrl, &slots, &entries);
+  }
+};
+
+/*
+ * Read-only Swiss table. A probe compares the 7-bit hash tag against a
+ * whole group of 16 control bytes with one SSE2 compare, and only reads
+ * the keys of the matching slots; a group with an empty slot ends the
+ * probe of a missing key. Keys, slot entries and payload tables (HSlot*)
+ * are separate arrays.
+ */
+template <class S>
+class SwissHashMapBase {
+ public:
+  typedef SwissSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef S value_type;
+  typedef typename traits_type::key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator()
+      : owner_(nullptr),
+        entry_(0) {}
+    ConstIterator(const SwissHashMapBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return *owner_->ptr_->entries()->Get(entry_);
+    }
+    const value_type* operator->() const {
+      return owner_->ptr_->entries()->Get(entry_);
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const SwissHashMapBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  SwissHashMapBase(const ft_type* hmap)
+    : ptr_(hmap) {
+    if (ptr_) {
+      ctrl_ = ptr_->ctrl()->data();
+      groupMask_ = ptr_->ctrl()->size() / detail::kSwissGroupSize - 1;
+    }
+  }
+
+  explicit SwissHashMapBase(const uint8_t* data)
+    : SwissHashMapBase(
+        data ? ::flatbuffers::GetRoot<ft_type>(data) : nullptr) {}
+  explicit SwissHashMapBase(::flatbuffers::DetachedBuffer&& data)
+    : SwissHashMapBase(data.data()) {
+    data_ = std::move(data);
+  }
+
+  SwissHashMapBase(const SwissHashMapBase&) = delete;
+  SwissHashMapBase& operator=(const SwissHashMapBase&) = delete;
+
+  SwissHashMapBase(SwissHashMapBase&&) = default;
+  SwissHashMapBase& operator=(SwissHashMapBase&&) = default;
+
+  size_t size() const {
+    return ptr_ ? ptr_->entries()->size() : 0;
+  }
+
+  // the positions forEachRange() visits, one per key
+  size_t scanSize() const {
+    return size();
+  }
+
+  // call f(const value_type&) for the keys at positions [begin, end),
+  // disjoint ranges may be visited by several threads at the same time
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    end = std::min(end, size());
+    for (size_t i = begin; i < end; i++) {
+      f(*ptr_->entries()->Get(i));
+    }
+  }
+
+  const_iterator find(const key_type& key) const {
+    return ConstIterator(*this, findEntry(key, hashKey(key)));
+  }
+
+  // look up n keys, the first group of each key is prefetched first
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    uint64_t hash[kBatchGroup];
+    for (size_t b = 0; b < n; b += kBatchGroup) {
+      size_t m = std::min(n - b, size_t(kBatchGroup));
+      for (size_t i = 0; i < m; i++) {
+        hash[i] = hashKey(keys[b + i]);
+        if (ctrl_) {
+          prefetch(ctrl_ + ((hash[i] >> 7) & groupMask_) *
+                           detail::kSwissGroupSize);
+        }
+      }
+      for (size_t i = 0; i < m; i++) {
+        out[b + i] = ConstIterator(*this, findEntry(keys[b + i], hash[i]));
+      }
+    }
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, size());
+  }
+
+ private:
+  enum : uint32_t {
+    kBatchGroup = 16,
+  };
+
+  uint32_t findEntry(const key_type& key, uint64_t hash) const {
+    if (!ctrl_) {
+      return size();
+    }
+    const ft_type* hmap = ptr_;
+    size_t slot = detail::swissFind(
+        ctrl_, groupMask_, hash,
+        [hmap, &key](size_t i) {
+          return traits_type::match(hmap, i, key);
+        });
+    return slot != size_t(-1) ? ptr_->slots()->Get(slot) : size();
+  }
+
+  const ft_type* ptr_{nullptr};
+  const uint8_t* ctrl_{nullptr};
+  size_t groupMask_{0};
+  ::flatbuffers::DetachedBuffer data_;
+};
+
+typedef SwissHashMapBase<fbs::HSlot32> SwissHashMap32;
+typedef SwissHashMapBase<fbs::HSlot64> SwissHashMap64;
+typedef SwissHashMapBase<fbs::HSlotS>  SwissHashMapS;
+
+} // namespace ftt
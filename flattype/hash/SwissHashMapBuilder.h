@@ -0,0 +1,231 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "accelerator/Bits.h"
+#include "flattype/Builder.h"
+#include "flattype/hash/SwissHashMap.h"
+
+namespace ftt {
+
+/*
+ * Builds a SwissHashMap in native arrays and serializes it once on
+ * finish(). The table doubles when it is 7/8 full, so maxSize is a hint,
+ * not a limit.
+ */
+template <class S>
+class SwissHashMapBuilderBase : public Builder {
+ public:
+  typedef SwissSlotTraits<S> traits_type;
+  typedef typename traits_type::map_type ft_type;
+  typedef typename S::NativeTableType value_type;
+  typedef typename traits_type::native_key_type key_type;
+
+  typedef struct ConstIterator {
+    ConstIterator(const SwissHashMapBuilderBase& owner, uint32_t entry)
+      : owner_(&owner),
+        entry_(entry) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return owner_->entries_[entry_];
+    }
+    const value_type* operator->() const {
+      return &owner_->entries_[entry_];
+    }
+
+    const ConstIterator& operator++() {
+      ++entry_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return entry_ == rhs.entry_;
+    }
+    bool operator!=(const ConstIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    const SwissHashMapBuilderBase* owner_;
+    uint32_t entry_;
+  } const_iterator;
+
+  friend ConstIterator;
+
+ public:
+  explicit SwissHashMapBuilderBase(size_t maxSize)
+    : Builder() {
+    init(maxSize);
+  }
+
+  SwissHashMapBuilderBase(size_t maxSize, FBB* fbb, bool owns = false)
+    : Builder(fbb, owns) {
+    init(maxSize);
+  }
+
+  void init(size_t maxSize) {
+    entries_.clear();
+    entries_.reserve(maxSize);
+    resize(acc::nextPowTwo(std::max(maxSize + maxSize / 7 + 1,
+                                    size_t(detail::kSwissGroupSize))));
+  }
+
+  SwissHashMapBuilderBase(const SwissHashMapBuilderBase&) = delete;
+  SwissHashMapBuilderBase& operator=(const SwissHashMapBuilderBase&) = delete;
+
+  SwissHashMapBuilderBase(SwissHashMapBuilderBase&&) = default;
+  SwissHashMapBuilderBase& operator=(SwissHashMapBuilderBase&&) = default;
+
+  std::pair<const_iterator, bool>
+  findOrConstruct(const key_type& key, const std::vector<uint64_t>& indexes) {
+    uint64_t hash = hashKey(key);
+    size_t slot = findSlot(hash, key);
+    if (slot != size_t(-1)) {
+      return std::make_pair(ConstIterator(*this, slots_[slot]), false);
+    }
+    if (entries_.size() >= maxEntries_) {
+      resize(ctrl_.size() * 2);
+    }
+
+    value_type slotObj;
+    slotObj.key = key;
+    slotObj.indexes = indexes;
+    entries_.push_back(std::move(slotObj));
+    place(hash, uint32_t(entries_.size() - 1));
+
+    return std::make_pair(ConstIterator(*this, entries_.size() - 1), true);
+  }
+
+  const_iterator find(const key_type& key) const {
+    size_t slot = findSlot(hashKey(key), key);
+    return ConstIterator(*this, slot != size_t(-1) ? slots_[slot]
+                                                   : entries_.size());
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  const_iterator cbegin() const {
+    return ConstIterator(*this, 0);
+  }
+
+  const_iterator cend() const {
+    return ConstIterator(*this, entries_.size());
+  }
+
+  // serialize into the FBB without finishing it, e.g. to embed the map
+  // in an Index
+  ::flatbuffers::Offset<ft_type> create() {
+    std::vector<::flatbuffers::Offset<S>> entries;
+    entries.reserve(entries_.size());
+    for (auto& entry : entries_) {
+      entries.push_back(S::Pack(*fbb_, &entry));
+    }
+    return traits_type::create(*fbb_, ctrl_, slots_, entries_, entries);
+  }
+
+  void finish() override {
+    if (finished_) {
+      return;
+    }
+    fbb_->Finish(create());
+    data_ = fbb_->Release();
+    finished_ = true;
+  }
+
+ private:
+  size_t findSlot(uint64_t hash, const key_type& key) const {
+    const SwissHashMapBuilderBase* self = this;
+    return detail::swissFind(
+        ctrl_.data(), groupMask_, hash,
+        [self, &key](size_t i) {
+          return self->entries_[self->slots_[i]].key == key;
+        });
+  }
+
+  void place(uint64_t hash, uint32_t entry) {
+    size_t slot = detail::swissFindEmpty(ctrl_.data(), groupMask_, hash);
+    ctrl_[slot] = detail::swissTag(hash);
+    slots_[slot] = entry;
+  }
+
+  void resize(size_t capacity) {
+    if (capacity > (size_t(1) << 32)) {
+      throw std::invalid_argument(
+          "SwissHashMap capacity must fit in 32 bits");
+    }
+    ctrl_.assign(capacity, detail::kSwissEmpty);
+    slots_.assign(capacity, 0);
+    groupMask_ = capacity / detail::kSwissGroupSize - 1;
+    // keep an empty slot so that every probe terminates
+    maxEntries_ = std::min(capacity - capacity / 8, capacity - 1);
+    for (uint32_t i = 0; i < entries_.size(); i++) {
+      place(hashKey(entries_[i].key), i);
+    }
+  }
+
+  std::vector<uint8_t> ctrl_;
+  std::vector<uint32_t> slots_;   // index into entries_ for each full slot
+  std::vector<value_type> entries_;
+  size_t groupMask_{0};
+  size_t maxEntries_{0};
+};
+
+class SwissHashMap32Builder : public SwissHashMapBuilderBase<fbs::HSlot32> {
+ public:
+  explicit SwissHashMap32Builder(size_t maxSize)
+    : SwissHashMapBuilderBase(maxSize) {}
+  SwissHashMap32Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : SwissHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  SwissHashMap32 toHashMap() { return toWrapper<SwissHashMap32>(); }
+};
+
+class SwissHashMap64Builder : public SwissHashMapBuilderBase<fbs::HSlot64> {
+ public:
+  explicit SwissHashMap64Builder(size_t maxSize)
+    : SwissHashMapBuilderBase(maxSize) {}
+  SwissHashMap64Builder(size_t maxSize, FBB* fbb, bool owns = false)
+    : SwissHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  SwissHashMap64 toHashMap() { return toWrapper<SwissHashMap64>(); }
+};
+
+class SwissHashMapSBuilder : public SwissHashMapBuilderBase<fbs::HSlotS> {
+ public:
+  explicit SwissHashMapSBuilder(size_t maxSize)
+    : SwissHashMapBuilderBase(maxSize) {}
+  SwissHashMapSBuilder(size_t maxSize, FBB* fbb, bool owns = false)
+    : SwissHashMapBuilderBase(maxSize, fbb, owns) {}
+
+  SwissHashMapS toHashMap() { return toWrapper<SwissHashMapS>(); }
+};
+
+} // namespace ftt
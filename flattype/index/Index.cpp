@@ -14,21 +14,24 @@
  * limitations under the License.
  */
 
-#include "accelerator/Conv.h"
 #include "flattype/index/Index.h"
 
 namespace ftt {
 
-std::string Index32::toDebugString() const {
-  return get() ?  acc::to<std::string>("{ 4:", getName(), " }") : "{}";
-}
-
-std::string Index64::toDebugString() const {
-  return get() ?  acc::to<std::string>("{ 8:", getName(), " }") : "{}";
-}
-
-std::string IndexS::toDebugString() const {
-  return get() ?  acc::to<std::string>("{ s:", getName(), " }") : "{}";
+const char* indexTag(fbs::HMap type) {
+  // in the order of the HMap union
+  static const char* kTags[] = {
+    "",
+    "4", "8", "s",
+    "f4", "f8", "fs",
+    "s4", "s8", "ss",
+    "p4", "p8", "ps",
+    "x4", "x8", "xs",
+    "o4", "o8", "os",
+    "c4", "c8", "cs",
+  };
+  size_t i = size_t(type);
+  return i < sizeof(kTags) / sizeof(kTags[0]) ? kTags[i] : "?";
 }
 
 } // namespace ftt
@@ -16,10 +16,23 @@
 
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "accelerator/Conv.h"
 #include "flattype/CommonIDLs.h"
 #include "flattype/Util.h"
 #include "flattype/Wrapper.h"
+#include "flattype/hash/BloomFilter.h"
+#include "flattype/hash/CuckooHashMap.h"
+#include "flattype/hash/FlatHashMap.h"
 #include "flattype/hash/HashMap.h"
+#include "flattype/hash/OrderedMap.h"
+#include "flattype/hash/PerfectHashMap.h"
+#include "flattype/hash/ShardedHashMap.h"
+#include "flattype/hash/SwissHashMap.h"
 
 namespace ftt {
 
@@ -29,17 +42,21 @@ class IndexBase : public Wrapper<fbs::Index> {
   typedef typename HMap::ft_type FTHMap;
   typedef typename HMap::key_type key_type;
   typedef typename HMap::const_iterator const_iterator;
+  typedef typename HMap::value_type value_type;
 
   IndexBase(const fbs::Index* index)
     : Wrapper(index),
-      hmap_(ptr_->hash_as<FTHMap>()) {}
+      hmap_(hashOf(ptr_)),
+      filter_(ptr_->filter()) {}
 
   explicit IndexBase(const uint8_t* data)
     : Wrapper(data),
-      hmap_(ptr_->hash_as<FTHMap>()) {}
+      hmap_(hashOf(ptr_)),
+      filter_(ptr_->filter()) {}
   explicit IndexBase(::flatbuffers::DetachedBuffer&& data)
     : Wrapper(std::move(data)),
-      hmap_(ptr_->hash_as<FTHMap>()) {}
+      hmap_(hashOf(ptr_)),
+      filter_(ptr_->filter()) {}
 
   IndexBase(const IndexBase&) = delete;
   IndexBase& operator=(const IndexBase&) = delete;
@@ -59,8 +76,74 @@ class IndexBase : public Wrapper<fbs::Index> {
     return hmap_;
   }
 
+  bool hasFilter() const {
+    return filter_ != nullptr;
+  }
+
+  // false if the filter rules the key out, true if it may be in the map
+  bool mayContain(const key_type& key) const {
+    return !filter_ ||
+      BloomFilter::mayContain(filter_->data(), filter_->size(), hashKey(key));
+  }
+
+  // a miss ruled out by the filter reads nothing of the map
   const_iterator find(const key_type& key) const {
-    return hmap_.find(key);
+    return mayContain(key) ? hmap_.find(key) : hmap_.cend();
+  }
+
+  void findBatch(const key_type* keys, size_t n, const_iterator* out) const {
+    if (!filter_) {
+      hmap_.findBatch(keys, n, out);
+      return;
+    }
+    // batch only the keys the filter lets through
+    std::vector<key_type> maybe;
+    std::vector<size_t> pos;
+    for (size_t i = 0; i < n; i++) {
+      if (mayContain(keys[i])) {
+        maybe.push_back(keys[i]);
+        pos.push_back(i);
+      } else {
+        out[i] = hmap_.cend();
+      }
+    }
+    std::vector<const_iterator> found(maybe.size());
+    hmap_.findBatch(maybe.data(), maybe.size(), found.data());
+    for (size_t i = 0; i < maybe.size(); i++) {
+      out[pos[i]] = found[i];
+    }
+  }
+
+  size_t scanSize() const {
+    return hmap_.scanSize();
+  }
+
+  // call f(const value_type&) for the keys at positions [begin, end) of
+  // the scan, see scanSize()
+  template <class F>
+  void forEachRange(size_t begin, size_t end, F&& f) const {
+    hmap_.forEachRange(begin, end, std::forward<F>(f));
+  }
+
+  // scan all the keys, split into a range per thread; f must be safe to
+  // call from several threads at the same time
+  template <class F>
+  void parallelForEach(size_t threads, F f) const {
+    size_t n = scanSize();
+    threads = std::max(std::min(threads, n), size_t(1));
+    if (threads == 1) {
+      forEachRange(0, n, f);
+      return;
+    }
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; t++) {
+      pool.emplace_back([this, &f, n, t, threads]() {
+        forEachRange(n * t / threads, n * (t + 1) / threads, f);
+      });
+    }
+    for (auto& th : pool) {
+      th.join();
+    }
   }
 
   const_iterator begin() const {
@@ -72,46 +155,106 @@ class IndexBase : public Wrapper<fbs::Index> {
   }
 
  private:
+  // the reader type has to match the format the Index was built with
+  static const FTHMap* hashOf(const fbs::Index* index) {
+    auto hash = index->hash_as<FTHMap>();
+    if (!hash) {
+      throw std::invalid_argument(acc::to<std::string>(
+          "Index of hash type ", int(index->hash_type()),
+          " read as type ", int(fbs::HMapTraits<FTHMap>::enum_value)));
+    }
+    return hash;
+  }
+
   HMap hmap_;
+  const ::flatbuffers::Vector<uint64_t>* filter_;
 };
 
-class Index32 : public IndexBase<HashMap32> {
+// an Index of an ordered map, with range lookups over the key order
+template <class OMap>
+class OrderedIndexBase : public IndexBase<OMap> {
  public:
-  Index32(const fbs::Index* index)
-    : IndexBase(index) {}
+  typedef IndexBase<OMap> Base;
+  typedef typename Base::key_type key_type;
+  typedef typename Base::const_iterator const_iterator;
 
-  explicit Index32(const uint8_t* data)
-    : IndexBase(data) {}
-  explicit Index32(::flatbuffers::DetachedBuffer&& data)
-    : IndexBase(std::move(data)) {}
+  OrderedIndexBase(const fbs::Index* index)
+    : Base(index) {}
 
-  std::string toDebugString() const override;
-};
+  explicit OrderedIndexBase(const uint8_t* data)
+    : Base(data) {}
+  explicit OrderedIndexBase(::flatbuffers::DetachedBuffer&& data)
+    : Base(std::move(data)) {}
 
-class Index64 : public IndexBase<HashMap64> {
- public:
-  Index64(const fbs::Index* index)
-    : IndexBase(index) {}
+  const_iterator lower_bound(const key_type& key) const {
+    return this->getHash().lower_bound(key);
+  }
 
-  explicit Index64(const uint8_t* data)
-    : IndexBase(data) {}
-  explicit Index64(::flatbuffers::DetachedBuffer&& data)
-    : IndexBase(std::move(data)) {}
+  const_iterator upper_bound(const key_type& key) const {
+    return this->getHash().upper_bound(key);
+  }
 
-  std::string toDebugString() const override;
+  std::pair<const_iterator, const_iterator>
+  range(const key_type& begin, const key_type& end) const {
+    return this->getHash().range(begin, end);
+  }
 };
 
-class IndexS : public IndexBase<HashMapS> {
+// the short tag of each hash type in toDebugString(), e.g. "f8" for FHMap64
+const char* indexTag(fbs::HMap type);
+
+/*
+ * The Index of one map format, Base adds the lookups of the format, see
+ * OrderedIndexBase.
+ */
+template <class HMap, class Base = IndexBase<HMap>>
+class IndexOf : public Base {
  public:
-  IndexS(const fbs::Index* index)
-    : IndexBase(index) {}
+  typedef typename Base::FTHMap FTHMap;
+
+  IndexOf(const fbs::Index* index)
+    : Base(index) {}
 
-  explicit IndexS(const uint8_t* data)
-    : IndexBase(data) {}
-  explicit IndexS(::flatbuffers::DetachedBuffer&& data)
-    : IndexBase(std::move(data)) {}
+  explicit IndexOf(const uint8_t* data)
+    : Base(data) {}
+  explicit IndexOf(::flatbuffers::DetachedBuffer&& data)
+    : Base(std::move(data)) {}
 
-  std::string toDebugString() const override;
+  std::string toDebugString() const override {
+    return this->get()
+      ? acc::to<std::string>(
+          "{ ", indexTag(fbs::HMapTraits<FTHMap>::enum_value), ":",
+          this->getName(), " }")
+      : "{}";
+  }
 };
 
+typedef IndexOf<HashMap32> Index32;
+typedef IndexOf<HashMap64> Index64;
+typedef IndexOf<HashMapS> IndexS;
+typedef IndexOf<FlatHashMap32> FlatIndex32;
+typedef IndexOf<FlatHashMap64> FlatIndex64;
+typedef IndexOf<FlatHashMapS> FlatIndexS;
+typedef IndexOf<SwissHashMap32> SwissIndex32;
+typedef IndexOf<SwissHashMap64> SwissIndex64;
+typedef IndexOf<SwissHashMapS> SwissIndexS;
+typedef IndexOf<PerfectHashMap32> PerfectIndex32;
+typedef IndexOf<PerfectHashMap64> PerfectIndex64;
+typedef IndexOf<PerfectHashMapS> PerfectIndexS;
+typedef IndexOf<ShardedHashMap32> ShardedIndex32;
+typedef IndexOf<ShardedHashMap64> ShardedIndex64;
+typedef IndexOf<ShardedHashMapS> ShardedIndexS;
+typedef IndexOf<OrderedMap32, OrderedIndexBase<OrderedMap32>> OrderedIndex32;
+typedef IndexOf<OrderedMap64, OrderedIndexBase<OrderedMap64>> OrderedIndex64;
+typedef IndexOf<OrderedMapS, OrderedIndexBase<OrderedMapS>> OrderedIndexS;
+typedef IndexOf<CuckooHashMap32> CuckooIndex32;
+typedef IndexOf<CuckooHashMap64> CuckooIndex64;
+typedef IndexOf<CuckooHashMapS> CuckooIndexS;
+
+// the keys of a string index starting with prefix
+inline std::pair<OrderedIndexS::const_iterator, OrderedIndexS::const_iterator>
+prefixRange(const OrderedIndexS& index, acc::StringPiece prefix) {
+  return prefixRange(index.getHash(), prefix);
+}
+
 } // namespace ftt
@@ -18,6 +18,7 @@
 
 #include "flattype/Builder.h"
 #include "flattype/CommonIDLs.h"
+#include "flattype/hash/BloomFilter.h"
 #include "flattype/index/Index.h"
 
 namespace ftt {
@@ -26,6 +27,7 @@ template <class HMap>
 class IndexBuilderBase : public Builder {
  public:
   typedef IndexBase<HMap> Index;
+  typedef typename HMap::ft_type FTHMap;
 
  public:
   IndexBuilderBase() : Builder() {}
@@ -50,45 +52,77 @@ class IndexBuilderBase : public Builder {
     hash_ = builder(fbb_.get());
   }
 
- protected:
-  std::string name_;
-  ::flatbuffers::Offset<void> hash_;
-};
+  // store a filter of the keys, e.g. from HashMapBuilderBase::buildFilter(),
+  // which find() consults before the map
+  void setFilter(const BloomFilter& filter) {
+    filter_ = filter.words();
+  }
 
-class Index32Builder : public IndexBuilderBase<HashMap32> {
- public:
-  Index32Builder()
-    : IndexBuilderBase() {}
-  explicit Index32Builder(FBB* fbb, bool owns = false)
-    : IndexBuilderBase(fbb, owns) {}
+  // the hash type is deduced from HMap
+  void finish() override {
+    if (finished_) {
+      return;
+    }
+    auto name = fbb_->CreateString(name_);
+    auto filter = createFilter();
+    fbb_->Finish(
+        fbs::CreateIndex(
+            *fbb_,
+            name,
+            fbs::HMapTraits<FTHMap>::enum_value,
+            hash_,
+            filter));
+    data_ = fbb_->Release();
+    finished_ = true;
+  }
 
-  void finish() override;
+ protected:
+  // one Bloom block per cache line
+  ::flatbuffers::Offset<::flatbuffers::Vector<uint64_t>> createFilter() {
+    if (filter_.empty()) {
+      return 0;
+    }
+    fbb_->ForceVectorAlignment(filter_.size(), sizeof(uint64_t), 64);
+    return fbb_->CreateVector(filter_);
+  }
 
-  Index32 toIndex() { return toWrapper<Index32>(); }
+  std::string name_;
+  ::flatbuffers::Offset<void> hash_;
+  std::vector<uint64_t> filter_;
 };
 
-class Index64Builder : public IndexBuilderBase<HashMap64> {
+// builds the Index of one map format, see IndexOf
+template <class HMap, class IndexType = IndexOf<HMap>>
+class IndexBuilderOf : public IndexBuilderBase<HMap> {
  public:
-  Index64Builder()
-    : IndexBuilderBase() {}
-  explicit Index64Builder(FBB* fbb, bool owns = false)
-    : IndexBuilderBase(fbb, owns) {}
-
-  void finish() override;
+  IndexBuilderOf()
+    : IndexBuilderBase<HMap>() {}
+  explicit IndexBuilderOf(FBB* fbb, bool owns = false)
+    : IndexBuilderBase<HMap>(fbb, owns) {}
 
-  Index64 toIndex() { return toWrapper<Index64>(); }
+  IndexType toIndex() { return this->template toWrapper<IndexType>(); }
 };
 
-class IndexSBuilder : public IndexBuilderBase<HashMapS> {
- public:
-  IndexSBuilder()
-    : IndexBuilderBase() {}
-  explicit IndexSBuilder(FBB* fbb, bool owns = false)
-    : IndexBuilderBase(fbb, owns) {}
-
-  void finish() override;
-
-  IndexS toIndex() { return toWrapper<IndexS>(); }
-};
+typedef IndexBuilderOf<HashMap32> Index32Builder;
+typedef IndexBuilderOf<HashMap64> Index64Builder;
+typedef IndexBuilderOf<HashMapS> IndexSBuilder;
+typedef IndexBuilderOf<FlatHashMap32> FlatIndex32Builder;
+typedef IndexBuilderOf<FlatHashMap64> FlatIndex64Builder;
+typedef IndexBuilderOf<FlatHashMapS> FlatIndexSBuilder;
+typedef IndexBuilderOf<SwissHashMap32> SwissIndex32Builder;
+typedef IndexBuilderOf<SwissHashMap64> SwissIndex64Builder;
+typedef IndexBuilderOf<SwissHashMapS> SwissIndexSBuilder;
+typedef IndexBuilderOf<PerfectHashMap32> PerfectIndex32Builder;
+typedef IndexBuilderOf<PerfectHashMap64> PerfectIndex64Builder;
+typedef IndexBuilderOf<PerfectHashMapS> PerfectIndexSBuilder;
+typedef IndexBuilderOf<ShardedHashMap32> ShardedIndex32Builder;
+typedef IndexBuilderOf<ShardedHashMap64> ShardedIndex64Builder;
+typedef IndexBuilderOf<ShardedHashMapS> ShardedIndexSBuilder;
+typedef IndexBuilderOf<OrderedMap32, OrderedIndex32> OrderedIndex32Builder;
+typedef IndexBuilderOf<OrderedMap64, OrderedIndex64> OrderedIndex64Builder;
+typedef IndexBuilderOf<OrderedMapS, OrderedIndexS> OrderedIndexSBuilder;
+typedef IndexBuilderOf<CuckooHashMap32> CuckooIndex32Builder;
+typedef IndexBuilderOf<CuckooHashMap64> CuckooIndex64Builder;
+typedef IndexBuilderOf<CuckooHashMapS> CuckooIndexSBuilder;
 
 } // namespace ftt
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "flattype/hash/PostingList.h"
+#include "flattype/hash/ShardedHashMap.h"
+#include "flattype/index/LayeredIndex.h"
+
+namespace ftt {
+
+// what merge() keeps of a key in both indexes
+enum class MergePolicy {
+  KeepLeft,       // the left slot
+  KeepRight,      // the right slot
+  UnionIndexes,   // the left slot with the indexes of both
+};
+
+namespace detail {
+
+// call f(t) for t in [0, threads) on as many threads, rethrows an error
+template <class F>
+void runOnThreads(size_t threads, F f) {
+  if (threads <= 1) {
+    f(0);
+    return;
+  }
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < threads; t++) {
+    pool.emplace_back([&f, &errors, t]() {
+      try {
+        f(t);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& th : pool) {
+    th.join();
+  }
+  for (auto& e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+// the slots at positions [begin, end) of map, by hashToShard()
+template <class M>
+void splitByShard(const M& map,
+                  size_t begin,
+                  size_t end,
+                  unsigned bits,
+                  std::vector<std::vector<const typename M::value_type*>>&
+                    out) {
+  map.forEachRange(begin, end, [&](const typename M::value_type& slot) {
+    out[hashToShard(hashKey(layerKey(slot.key())), bits)].push_back(&slot);
+  });
+}
+
+// add the indexes of right to out, the unpacked left slot
+template <class N, class S>
+void unionIndexes(N& out, const S& left, const S& right) {
+  if (left.postings() || right.postings()) {
+    std::vector<BIndex> indexes;
+    auto add = [&](BIndex i) { indexes.push_back(i); };
+    visitIndexes(&left, add);
+    visitIndexes(&right, add);
+    out.postings = encodePostings(std::move(indexes));
+    out.indexes.clear();
+    return;
+  }
+  if (!right.indexes()) {
+    return;
+  }
+  std::vector<uint64_t> seen(out.indexes);
+  std::sort(seen.begin(), seen.end());
+  for (uint64_t i : *right.indexes()) {
+    if (!std::binary_search(seen.begin(), seen.end(), i)) {
+      out.indexes.push_back(i);
+    }
+  }
+}
+
+} // namespace detail
+
+/*
+ * Merge the slots of two indexes (or maps) with the same slot type into
+ * native entries for bulk builds: every key of either side once, a key in
+ * both resolved by policy. The inputs are read as dense entry streams
+ * (forEachRange), split by hashToShard() into 2^bits partitions; each
+ * partition is merged with a hash table of its right keys, so the merge
+ * is linear in the entries, and the partitions are merged on `threads`
+ * threads. Slots are copied as they are, tombstones included.
+ *
+ * Partition i holds the entries of shard i of a ShardedHashMapBuilder of
+ * the same bits, ready for buildShard(i), left keys first.
+ */
+template <class Left, class Right>
+std::vector<std::vector<typename Left::value_type::NativeTableType>>
+mergeShards(const Left& left,
+            const Right& right,
+            MergePolicy policy,
+            unsigned bits,
+            size_t threads = 1) {
+  typedef typename Left::value_type value_type;
+  typedef typename value_type::NativeTableType native_type;
+  typedef decltype(detail::layerKey(std::declval<value_type>().key()))
+    key_type;
+  typedef std::vector<std::vector<const value_type*>> split_type;
+
+  static_assert(std::is_same<value_type, typename Right::value_type>::value,
+                "merge of indexes with different slots");
+  if (bits > kMaxShardBits) {
+    throw std::invalid_argument("HashMap shard bits must be at most 16");
+  }
+  size_t parts = size_t(1) << bits;
+  threads = std::max(threads, size_t(1));
+
+  // split both sides, a range of each per thread
+  std::vector<split_type> lsplit(threads, split_type(parts));
+  std::vector<split_type> rsplit(threads, split_type(parts));
+  detail::runOnThreads(threads, [&](size_t t) {
+    size_t nl = left.scanSize();
+    size_t nr = right.scanSize();
+    detail::splitByShard(left, nl * t / threads, nl * (t + 1) / threads,
+                         bits, lsplit[t]);
+    detail::splitByShard(right, nr * t / threads, nr * (t + 1) / threads,
+                         bits, rsplit[t]);
+  });
+
+  std::vector<std::vector<native_type>> out(parts);
+  detail::runOnThreads(std::min(threads, parts), [&](size_t t) {
+    size_t step = std::min(threads, parts);
+    for (size_t p = t; p < parts; p += step) {
+      std::unordered_map<key_type, const value_type*,
+                         detail::LayerKeyHash<key_type>> rights;
+      for (auto& split : rsplit) {
+        for (auto slot : split[p]) {
+          rights.emplace(detail::layerKey(slot->key()), slot);
+        }
+      }
+      auto& entries = out[p];
+      for (auto& split : lsplit) {
+        for (auto slot : split[p]) {
+          entries.emplace_back();
+          auto it = rights.find(detail::layerKey(slot->key()));
+          if (it == rights.end()) {
+            slot->UnPackTo(&entries.back());
+            continue;
+          }
+          if (policy == MergePolicy::KeepRight) {
+            it->second->UnPackTo(&entries.back());
+          } else {
+            slot->UnPackTo(&entries.back());
+            if (policy == MergePolicy::UnionIndexes) {
+              detail::unionIndexes(entries.back(), *slot, *it->second);
+            }
+          }
+          it->second = nullptr;
+        }
+      }
+      for (auto& split : rsplit) {
+        for (auto slot : split[p]) {
+          if (rights[detail::layerKey(slot->key())] == slot) {
+            entries.emplace_back();
+            slot->UnPackTo(&entries.back());
+          }
+        }
+      }
+    }
+  });
+  return out;
+}
+
+/*
+ * mergeShards() into a single list, e.g. for HashMapBuilderBase::build(),
+ * partitioned by a shard per thread.
+ */
+template <class Left, class Right>
+std::vector<typename Left::value_type::NativeTableType>
+merge(const Left& left,
+      const Right& right,
+      MergePolicy policy,
+      size_t threads = 1) {
+  unsigned bits = 0;
+  while ((size_t(1) << bits) < threads && bits < kMaxShardBits) {
+    bits++;
+  }
+  auto parts = mergeShards(left, right, policy, bits, threads);
+  size_t n = 0;
+  for (auto& part : parts) {
+    n += part.size();
+  }
+  std::vector<typename Left::value_type::NativeTableType> entries;
+  entries.reserve(n);
+  for (auto& part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(entries));
+  }
+  return entries;
+}
+
+} // namespace ftt
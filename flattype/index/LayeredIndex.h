@@ -0,0 +1,274 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "flattype/SnapshotHolder.h"
+#include "flattype/Util.h"
+#include "flattype/hash/BloomFilter.h"
+#include "flattype/hash/Hash.h"
+#include "flattype/index/Index.h"
+
+namespace ftt {
+
+namespace detail {
+
+inline uint32_t layerKey(uint32_t key) {
+  return key;
+}
+inline uint64_t layerKey(uint64_t key) {
+  return key;
+}
+inline acc::StringPiece layerKey(const ::flatbuffers::String* key) {
+  return stringPiece(key);
+}
+
+template <class K>
+struct LayerKeyHash {
+  size_t operator()(const K& key) const {
+    return hashKey(key);
+  }
+};
+
+} // namespace detail
+
+/*
+ * An immutable base index (e.g. mmapped) overlaid with small delta
+ * layers, so that updates don't need a rebuild of the base. A key is
+ * looked up in the layers newest first, then in the base; a slot with
+ * deleted set (a tombstone) hides the key from the older layers. Each
+ * layer has an in-memory Bloom filter of its keys, so most lookups skip
+ * the layers without reading them.
+ *
+ * Lookups go through a snapshot(), a read guard of a SnapshotHolder:
+ * taking it is wait-free, with no lock and no shared reference count.
+ * addLayer() and merge() publish new snapshots and wait for the readers
+ * of the old one, so a guard must not be held across them, nor longer
+ * than a request; copy the Snapshot, which shares its base and layers,
+ * to keep it longer. merge() compacts the layers into a new base built
+ * by a Compactor, e.g. from a HashMapBuilder bulk build, while the
+ * readers keep using the current snapshot.
+ */
+template <class Base, class Delta = Base>
+class LayeredIndex {
+ public:
+  typedef typename Base::key_type key_type;
+  typedef typename Base::value_type value_type;
+  typedef typename value_type::NativeTableType native_type;
+
+  static_assert(std::is_same<value_type, typename Delta::value_type>::value,
+                "LayeredIndex layers must have the slots of the base");
+
+  // builds the new base from the live entries, in a deterministic order
+  typedef std::function<
+    std::unique_ptr<Base>(std::vector<native_type>&&)> Compactor;
+
+  class Snapshot {
+   public:
+    // the slot of key, nullptr if the key is missing or deleted
+    const value_type* find(const key_type& key) const {
+      uint64_t hash = hashKey(key);
+      for (size_t i = layers_.size(); i-- > 0; ) {
+        auto& layer = layers_[i];
+        if (!layer.filter.mayContain(hash)) {
+          continue;
+        }
+        auto it = layer.index->find(key);
+        if (it != layer.index->end()) {
+          return it->deleted() ? nullptr : &*it;
+        }
+      }
+      auto it = base_->find(key);
+      return it != base_->end() && !it->deleted() ? &*it : nullptr;
+    }
+
+    const Base& base() const {
+      return *base_;
+    }
+
+    size_t layerCount() const {
+      return layers_.size();
+    }
+
+    // the layers oldest first
+    const Delta& layer(size_t i) const {
+      return *layers_[i].index;
+    }
+
+   private:
+    friend class LayeredIndex;
+
+    struct Layer {
+      std::shared_ptr<const Delta> index;
+      BloomFilter filter;
+    };
+
+    std::shared_ptr<const Base> base_;
+    std::vector<Layer> layers_;
+  };
+
+  typedef typename SnapshotHolder<Snapshot>::ReadGuard ReadGuard;
+
+  explicit LayeredIndex(std::unique_ptr<Base> base) {
+    std::unique_ptr<Snapshot> snapshot(new Snapshot());
+    snapshot->base_ = std::move(base);
+    snapshot_.publish(std::move(snapshot));
+  }
+
+  ~LayeredIndex() {
+    if (merger_.joinable()) {
+      merger_.join();
+    }
+  }
+
+  LayeredIndex(const LayeredIndex&) = delete;
+  LayeredIndex& operator=(const LayeredIndex&) = delete;
+
+  ReadGuard snapshot() const {
+    return snapshot_.read();
+  }
+
+  // add the newest layer
+  void addLayer(std::unique_ptr<Delta> layer) {
+    typename Snapshot::Layer added;
+    added.filter = BloomFilter(layer->scanSize());
+    layer->forEachRange(0, layer->scanSize(), [&](const value_type& slot) {
+      added.filter.add(hashKey(detail::layerKey(slot.key())));
+    });
+    added.index = std::move(layer);
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::unique_ptr<Snapshot> next(new Snapshot(*snapshot()));
+    next->layers_.push_back(std::move(added));
+    snapshot_.publish(std::move(next));
+  }
+
+  /*
+   * Compact the layers of the current snapshot into a new base. Layers
+   * added meanwhile are kept on top of it. The deleted keys are dropped,
+   * the entries of the base keep their scan order and the keys new in the
+   * layers follow, oldest layer first.
+   */
+  void merge(const Compactor& compact) {
+    std::lock_guard<std::mutex> merging(mergeMutex_);
+    // a copy, the guard would hold back the publish below
+    const Snapshot from = *snapshot();
+    if (from.layers_.empty()) {
+      return;
+    }
+    std::shared_ptr<const Base> base = compact(mergeEntries(from));
+    if (!base) {
+      throw std::runtime_error("LayeredIndex compactor returned no base");
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::unique_ptr<Snapshot> next(new Snapshot());
+    next->base_ = std::move(base);
+    {
+      auto current = snapshot();
+      next->layers_.assign(current->layers_.begin() + from.layers_.size(),
+                           current->layers_.end());
+    }
+    snapshot_.publish(std::move(next));
+  }
+
+  // merge() in a background thread, waiting for the previous one first
+  void mergeAsync(Compactor compact) {
+    waitMerge();
+    merger_ = std::thread([this, compact]() {
+      try {
+        merge(compact);
+      } catch (...) {
+        error_ = std::current_exception();
+      }
+    });
+  }
+
+  // wait for mergeAsync(), rethrows its error
+  void waitMerge() {
+    if (merger_.joinable()) {
+      merger_.join();
+    }
+    if (error_) {
+      auto error = error_;
+      error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  typedef decltype(detail::layerKey(std::declval<value_type>().key()))
+    layer_key_type;
+
+  static void append(std::vector<native_type>& entries,
+                     const value_type& slot) {
+    if (!slot.deleted()) {
+      entries.emplace_back();
+      slot.UnPackTo(&entries.back());
+    }
+  }
+
+  static std::vector<native_type> mergeEntries(const Snapshot& from) {
+    std::unordered_map<layer_key_type, const value_type*,
+                       detail::LayerKeyHash<layer_key_type>> newest;
+    for (size_t i = from.layers_.size(); i-- > 0; ) {
+      auto& layer = *from.layers_[i].index;
+      layer.forEachRange(0, layer.scanSize(), [&](const value_type& slot) {
+        newest.emplace(detail::layerKey(slot.key()), &slot);
+      });
+    }
+
+    std::vector<native_type> entries;
+    entries.reserve(from.base_->scanSize() + newest.size());
+    from.base_->forEachRange(
+        0, from.base_->scanSize(), [&](const value_type& slot) {
+      auto it = newest.find(detail::layerKey(slot.key()));
+      if (it == newest.end()) {
+        append(entries, slot);
+      } else {
+        append(entries, *it->second);
+        newest.erase(it);
+      }
+    });
+    for (auto& l : from.layers_) {
+      l.index->forEachRange(0, l.index->scanSize(), [&](const value_type& s) {
+        auto it = newest.find(detail::layerKey(s.key()));
+        if (it != newest.end() && it->second == &s) {
+          append(entries, s);
+          newest.erase(it);
+        }
+      });
+    }
+    return entries;
+  }
+
+  SnapshotHolder<Snapshot> snapshot_;
+  std::mutex mutex_;        // serializes the publishers
+  std::mutex mergeMutex_;   // one merge at a time
+  std::thread merger_;
+  std::exception_ptr error_;
+};
+
+} // namespace ftt
@@ -19,7 +19,7 @@
 
 namespace ftt {
 
-std::string ColumnarMatrix::toDebugString() const {
+std::string ColumnarMatrixRef::toDebugString() const {
   std::string out;
   if (!get()) {
     return "{}";
@@ -23,6 +23,33 @@
 
 namespace ftt {
 
+class ColumnarMatrixRef : public Ref<fbs::Matrix> {
+ public:
+  ColumnarMatrixRef() {}
+  ColumnarMatrixRef(const fbs::Matrix* matrix) : Ref(matrix) {}
+
+  std::string toDebugString() const;
+
+  size_t getRowCount() const;
+  size_t getColCount() const;
+
+  const fbs::Record* getCol(size_t j) const;
+  const fbs::Item* getItem(size_t i, size_t j) const;
+
+  template <class... Args>
+  bool getRowValue(size_t i, Args&... args) const;
+  template <class... Args>
+  bool getColValue(size_t j, Args&... args) const;
+  template <class T>
+  bool getItemValue(size_t i, size_t j, T& value) const;
+
+  fbs::Any getItemType(size_t i, size_t j) const;
+};
+
+static_assert(sizeof(ColumnarMatrixRef) == sizeof(void*) &&
+              std::is_trivially_copyable<ColumnarMatrixRef>::value,
+              "ColumnarMatrixRef must stay a trivially copyable pointer");
+
 class ColumnarMatrix : public Wrapper<fbs::Matrix> {
  public:
   ColumnarMatrix(const fbs::Matrix* matrix) : Wrapper(matrix) {}
@@ -38,44 +65,64 @@ class ColumnarMatrix : public Wrapper<fbs::Matrix> {
   ColumnarMatrix(ColumnarMatrix&&) = default;
   ColumnarMatrix& operator=(ColumnarMatrix&&) = default;
 
-  std::string toDebugString() const override;
+  ColumnarMatrixRef ref() const { return ColumnarMatrixRef(ptr_); }
 
-  size_t getRowCount() const;
-  size_t getColCount() const;
+  std::string toDebugString() const override {
+    return ref().toDebugString();
+  }
 
-  const fbs::Record* getCol(size_t j) const;
-  const fbs::Item* getItem(size_t i, size_t j) const;
+  size_t getRowCount() const {
+    return ref().getRowCount();
+  }
+  size_t getColCount() const {
+    return ref().getColCount();
+  }
+
+  const fbs::Record* getCol(size_t j) const {
+    return ref().getCol(j);
+  }
+  const fbs::Item* getItem(size_t i, size_t j) const {
+    return ref().getItem(i, j);
+  }
 
   template <class... Args>
-  bool getRowValue(size_t i, Args&... args) const;
+  bool getRowValue(size_t i, Args&... args) const {
+    return ref().getRowValue(i, args...);
+  }
   template <class... Args>
-  bool getColValue(size_t j, Args&... args) const;
+  bool getColValue(size_t j, Args&... args) const {
+    return ref().getColValue(j, args...);
+  }
   template <class T>
-  bool getItemValue(size_t i, size_t j, T& value) const;
+  bool getItemValue(size_t i, size_t j, T& value) const {
+    return ref().getItemValue(i, j, value);
+  }
 
-  fbs::Any getItemType(size_t i, size_t j) const;
+  fbs::Any getItemType(size_t i, size_t j) const {
+    return ref().getItemType(i, j);
+  }
 };
 
 //////////////////////////////////////////////////////////////////////
 
 inline size_t
-ColumnarMatrix::getRowCount() const {
+ColumnarMatrixRef::getRowCount() const {
   auto col = getCol(0);
   return col ? ftt::size(col) : 0;
 }
 
 inline size_t
-ColumnarMatrix::getColCount() const {
+ColumnarMatrixRef::getColCount() const {
   return ftt::size(ptr_);
 }
 
 inline const fbs::Record*
-ColumnarMatrix::getCol(size_t j) const {
+ColumnarMatrixRef::getCol(size_t j) const {
   return j < ftt::size(ptr_) ? ftt::at(ptr_, j) : nullptr;
 }
 
 inline const fbs::Item*
-ColumnarMatrix::getItem(size_t i, size_t j) const {
+ColumnarMatrixRef::getItem(size_t i, size_t j) const {
   auto col = getCol(j);
   if (col) {
     return i < ftt::size(col) ? ftt::at(col, i) : nullptr;
@@ -85,7 +132,7 @@ ColumnarMatrix::getItem(size_t i, size_t j) const {
 
 template <class... Args>
 inline bool
-ColumnarMatrix::getRowValue(size_t i, Args&... args) const {
+ColumnarMatrixRef::getRowValue(size_t i, Args&... args) const {
   if (i < getRowCount()) {
     decodeOne(ptr_, i, args...);
     return true;
@@ -95,7 +142,7 @@ ColumnarMatrix::getRowValue(size_t i, Args&... args) const {
 
 template <class... Args>
 inline bool
-ColumnarMatrix::getColValue(size_t j, Args&... args) const {
+ColumnarMatrixRef::getColValue(size_t j, Args&... args) const {
   auto col = getCol(j);
   if (col) {
     decode(col, args...);
@@ -106,7 +153,7 @@ ColumnarMatrix::getColValue(size_t j, Args&... args) const {
 
 template <class T>
 inline bool
-ColumnarMatrix::getItemValue(size_t i, size_t j, T& value) const {
+ColumnarMatrixRef::getItemValue(size_t i, size_t j, T& value) const {
   auto item = getItem(i, j);
   if (item) {
     decode(item, value);
@@ -116,7 +163,7 @@ ColumnarMatrix::getItemValue(size_t i, size_t j, T& value) const {
 }
 
 inline fbs::Any
-ColumnarMatrix::getItemType(size_t i, size_t j) const {
+ColumnarMatrixRef::getItemType(size_t i, size_t j) const {
   auto item = getItem(i, j);
   return item ? item->value_type() : fbs::Any::NONE;
 }
@@ -68,7 +68,15 @@ class ColumnarMatrixBuilder : public Builder {
  private:
   void resize(size_t i, size_t j);
 
+  // bookkeeping of sizes_, k and l index records_[k][l]
+  void retire(size_t k, size_t l, size_t mark);
+  void retireRecord(size_t k);
+  void appended(size_t k, size_t mark);
+  void rewritten(size_t n, size_t l, size_t mark);
+
   std::vector<std::vector<Item>> records_;
+  // bytes written for each item, counted as dead once overwritten
+  std::vector<std::vector<uint32_t>> sizes_;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -76,9 +84,45 @@ class ColumnarMatrixBuilder : public Builder {
 inline void ColumnarMatrixBuilder::resize(size_t i, size_t j) {
   if (j >= records_.size()) {
     records_.resize(j + 1);
+    sizes_.resize(j + 1);
   }
   if (i >= records_[j].size()) {
     records_[j].resize(i + 1);
+    sizes_[j].resize(i + 1);
+  }
+}
+
+// item (k, l) was rewritten with the bytes written since mark
+inline void ColumnarMatrixBuilder::retire(size_t k, size_t l, size_t mark) {
+  deadBytes_ += sizes_[k][l];
+  sizes_[k][l] = fbb_->GetSize() - mark;
+}
+
+inline void ColumnarMatrixBuilder::retireRecord(size_t k) {
+  for (auto size : sizes_[k]) {
+    deadBytes_ += size;
+  }
+  sizes_[k].clear();
+}
+
+// items of record k were appended since mark, one after another
+inline void ColumnarMatrixBuilder::appended(size_t k, size_t mark) {
+  for (size_t l = sizes_[k].size(); l < records_[k].size(); l++) {
+    sizes_[k].push_back(records_[k][l].o - mark);
+    mark = records_[k][l].o;
+  }
+}
+
+// items (0, l) to (n - 1, l) were rewritten since mark, one after another
+inline void ColumnarMatrixBuilder::rewritten(size_t n, size_t l, size_t mark) {
+  for (size_t k = 0; k < n; k++) {
+    if (l < sizes_[k].size()) {
+      deadBytes_ += sizes_[k][l];
+    } else {
+      sizes_[k].resize(l + 1);
+    }
+    sizes_[k][l] = records_[k][l].o - mark;
+    mark = records_[k][l].o;
   }
 }
 
@@ -104,7 +148,9 @@ inline void
 ColumnarMatrixBuilder::setItem(size_t i, size_t j, const fbs::Item* item) {
   assert(item != nullptr);
   resize(i, j);
+  size_t mark = fbb_->GetSize();
   records_[j][i] = copy(*fbb_, *item);
+  retire(j, i, mark);
 }
 
 template <class... Args>
@@ -121,7 +167,9 @@ template <class... Args>
 inline bool
 ColumnarMatrixBuilder::setRowValue(size_t i, const Args&... args) {
   resize(0, sizeof...(Args));
-  vvencodeItems(*fbb_, records_, i, args...);
+  size_t mark = fbb_->GetSize();
+  vvencodeItems(*fbb_, records_, i, vectorAlignment_, args...);
+  rewritten(sizeof...(Args), i, mark);
   return true;
 }
 
@@ -139,8 +187,11 @@ template <class... Args>
 inline bool
 ColumnarMatrixBuilder::setColValue(size_t j, const Args&... args) {
   resize(0, j);
+  retireRecord(j);
   records_[j].clear();
-  vencodeItems(*fbb_, records_[j], args...);
+  size_t mark = fbb_->GetSize();
+  vencodeItems(*fbb_, records_[j], vectorAlignment_, args...);
+  appended(j, mark);
   return true;
 }
 
@@ -159,8 +210,10 @@ template <class T>
 inline bool
 ColumnarMatrixBuilder::setItemValue(size_t i, size_t j, const T& value) {
   resize(i, j);
-  auto item = encode(*fbb_, value);
+  size_t mark = fbb_->GetSize();
+  auto item = encodeAligned(*fbb_, value, vectorAlignment_);
   records_[j][i] = fbs::CreateItem(*fbb_, getAnyType<T>(), item.Union());
+  retire(j, i, mark);
   return true;
 }
 
@@ -88,23 +88,23 @@ getTypes(std::vector<ftt::fbs::Any>& types) {
 
 //////////////////////////////////////////////////////////////////////
 
-// vector<Item> encoding
+// vector<Item> encoding, numeric arrays aligned as by encodeAligned()
 template <class T>
 inline void
 vencodeItems(::flatbuffers::FlatBufferBuilder& fbb,
              std::vector<flatbuffers::Offset<fbs::Item>>& items,
-             const T& arg) {
-  auto item = fbs::CreateItem(fbb, getAnyType<T>(), encode(fbb, arg).Union());
-  items.push_back(item);
+             size_t alignment, const T& arg) {
+  auto value = encodeAligned(fbb, arg, alignment);
+  items.push_back(fbs::CreateItem(fbb, getAnyType<T>(), value.Union()));
 }
 
 template <class T, class... Args>
 inline void
 vencodeItems(::flatbuffers::FlatBufferBuilder& fbb,
              std::vector<flatbuffers::Offset<fbs::Item>>& items,
-             const T& arg, const Args&... args) {
-  vencodeItems(fbb, items, arg);
-  vencodeItems(fbb, items, args...);
+             size_t alignment, const T& arg, const Args&... args) {
+  vencodeItems(fbb, items, alignment, arg);
+  vencodeItems(fbb, items, alignment, args...);
 }
 
 // vector<Item> decoding
@@ -135,13 +135,15 @@ vdecodeItems(::flatbuffers::FlatBufferBuilder& fbb,
   vdecodeItems<0>(fbb, items, args...);
 }
 
-// vector<vector<Item>> encoding
+// vector<vector<Item>> encoding, numeric arrays aligned as by
+// encodeAligned()
 template <int I, class T>
 inline void
 vvencodeItems(::flatbuffers::FlatBufferBuilder& fbb,
               vvector<flatbuffers::Offset<fbs::Item>>& items,
-              size_t j, const T& arg) {
-  auto item = fbs::CreateItem(fbb, getAnyType<T>(), encode(fbb, arg).Union());
+              size_t j, size_t alignment, const T& arg) {
+  auto value = encodeAligned(fbb, arg, alignment);
+  auto item = fbs::CreateItem(fbb, getAnyType<T>(), value.Union());
   if (j >= items[I].size()) {
     items[I].resize(j + 1);
   }
@@ -152,17 +154,18 @@ template <int I, class T, class... Args>
 inline void
 vvencodeItems(::flatbuffers::FlatBufferBuilder& fbb,
               vvector<flatbuffers::Offset<fbs::Item>>& items,
-              size_t j, const T& arg, const Args&... args) {
-  vvencodeItems<I>(fbb, items, j, arg);
-  vvencodeItems<I+1>(fbb, items, j, args...);
+              size_t j, size_t alignment,
+              const T& arg, const Args&... args) {
+  vvencodeItems<I>(fbb, items, j, alignment, arg);
+  vvencodeItems<I+1>(fbb, items, j, alignment, args...);
 }
 
 template <class... Args>
 inline void
 vvencodeItems(::flatbuffers::FlatBufferBuilder& fbb,
               vvector<flatbuffers::Offset<fbs::Item>>& items,
-              size_t j, const Args&... args) {
-  vvencodeItems<0>(fbb, items, j, args...);
+              size_t j, size_t alignment, const Args&... args) {
+  vvencodeItems<0>(fbb, items, j, alignment, args...);
 }
 
 // vector<vector<Item>> decoding
@@ -19,7 +19,7 @@
 
 namespace ftt {
 
-std::string Matrix::toDebugString() const {
+std::string MatrixRef::toDebugString() const {
   std::string out;
   if (!get()) {
     return "{}";
@@ -23,6 +23,54 @@
 
 namespace ftt {
 
+class RecordRef : public Ref<fbs::Record> {
+ public:
+  RecordRef() {}
+  RecordRef(const fbs::Record* record) : Ref(record) {}
+
+  size_t getCount() const;
+
+  const fbs::Item* getItem(size_t j) const;
+
+  template <class... Args>
+  bool getValue(Args&... args) const;
+  template <class T>
+  bool getItemValue(size_t j, T& value) const;
+
+  fbs::Any getItemType(size_t j) const;
+};
+
+static_assert(sizeof(RecordRef) == sizeof(void*) &&
+              std::is_trivially_copyable<RecordRef>::value,
+              "RecordRef must stay a trivially copyable pointer");
+
+class MatrixRef : public Ref<fbs::Matrix> {
+ public:
+  MatrixRef() {}
+  MatrixRef(const fbs::Matrix* matrix) : Ref(matrix) {}
+
+  std::string toDebugString() const;
+
+  size_t getRowCount() const;
+  size_t getColCount() const;
+
+  const fbs::Record* getRow(size_t i) const;
+  const fbs::Item* getItem(size_t i, size_t j) const;
+
+  template <class... Args>
+  bool getRowValue(size_t i, Args&... args) const;
+  template <class... Args>
+  bool getColValue(size_t j, Args&... args) const;
+  template <class T>
+  bool getItemValue(size_t i, size_t j, T& value) const;
+
+  fbs::Any getItemType(size_t i, size_t j) const;
+};
+
+static_assert(sizeof(MatrixRef) == sizeof(void*) &&
+              std::is_trivially_copyable<MatrixRef>::value,
+              "MatrixRef must stay a trivially copyable pointer");
+
 class Matrix : public Wrapper<fbs::Matrix> {
  public:
   Matrix(const fbs::Matrix* matrix) : Wrapper(matrix) {}
@@ -38,44 +86,100 @@ class Matrix : public Wrapper<fbs::Matrix> {
   Matrix(Matrix&&) = default;
   Matrix& operator=(Matrix&&) = default;
 
-  std::string toDebugString() const override;
+  MatrixRef ref() const { return MatrixRef(ptr_); }
 
-  size_t getRowCount() const;
-  size_t getColCount() const;
+  std::string toDebugString() const override {
+    return ref().toDebugString();
+  }
 
-  const fbs::Record* getRow(size_t i) const;
-  const fbs::Item* getItem(size_t i, size_t j) const;
+  size_t getRowCount() const {
+    return ref().getRowCount();
+  }
+  size_t getColCount() const {
+    return ref().getColCount();
+  }
+
+  const fbs::Record* getRow(size_t i) const {
+    return ref().getRow(i);
+  }
+  const fbs::Item* getItem(size_t i, size_t j) const {
+    return ref().getItem(i, j);
+  }
 
   template <class... Args>
-  bool getRowValue(size_t i, Args&... args) const;
+  bool getRowValue(size_t i, Args&... args) const {
+    return ref().getRowValue(i, args...);
+  }
   template <class... Args>
-  bool getColValue(size_t j, Args&... args) const;
+  bool getColValue(size_t j, Args&... args) const {
+    return ref().getColValue(j, args...);
+  }
   template <class T>
-  bool getItemValue(size_t i, size_t j, T& value) const;
+  bool getItemValue(size_t i, size_t j, T& value) const {
+    return ref().getItemValue(i, j, value);
+  }
 
-  fbs::Any getItemType(size_t i, size_t j) const;
+  fbs::Any getItemType(size_t i, size_t j) const {
+    return ref().getItemType(i, j);
+  }
 };
 
 //////////////////////////////////////////////////////////////////////
 
 inline size_t
-Matrix::getRowCount() const {
+RecordRef::getCount() const {
+  return ftt::size(ptr_);
+}
+
+inline const fbs::Item*
+RecordRef::getItem(size_t j) const {
+  return j < ftt::size(ptr_) ? ftt::at(ptr_, j) : nullptr;
+}
+
+template <class... Args>
+inline bool
+RecordRef::getValue(Args&... args) const {
+  decode(ptr_, args...);
+  return true;
+}
+
+template <class T>
+inline bool
+RecordRef::getItemValue(size_t j, T& value) const {
+  auto item = getItem(j);
+  if (item) {
+    decode(item, value);
+    return true;
+  }
+  return false;
+}
+
+inline fbs::Any
+RecordRef::getItemType(size_t j) const {
+  auto item = getItem(j);
+  return item ? item->value_type() : fbs::Any::NONE;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+inline size_t
+MatrixRef::getRowCount() const {
   return ftt::size(ptr_);
 }
 
 inline size_t
-Matrix::getColCount() const {
+MatrixRef::getColCount() const {
   auto row = getRow(0);
   return row ? ftt::size(row) : 0;
 }
 
 inline const fbs::Record*
-Matrix::getRow(size_t i) const {
+MatrixRef::getRow(size_t i) const {
   return i < ftt::size(ptr_) ? ftt::at(ptr_, i) : nullptr;
 }
 
 inline const fbs::Item*
-Matrix::getItem(size_t i, size_t j) const {
+MatrixRef::getItem(size_t i, size_t j) const {
   auto row = getRow(i);
   if (row) {
     return j < ftt::size(row) ? ftt::at(row, j) : nullptr;
@@ -85,7 +189,7 @@ Matrix::getItem(size_t i, size_t j) const {
 
 template <class... Args>
 inline bool
-Matrix::getRowValue(size_t i, Args&... args) const {
+MatrixRef::getRowValue(size_t i, Args&... args) const {
   auto row = getRow(i);
   if (row) {
     decode(row, args...);
@@ -96,7 +200,7 @@ Matrix::getRowValue(size_t i, Args&... args) const {
 
 template <class... Args>
 inline bool
-Matrix::getColValue(size_t j, Args&... args) const {
+MatrixRef::getColValue(size_t j, Args&... args) const {
   if (j < getColCount()) {
     decodeOne(ptr_, j, args...);
     return true;
@@ -106,7 +210,7 @@ Matrix::getColValue(size_t j, Args&... args) const {
 
 template <class T>
 inline bool
-Matrix::getItemValue(size_t i, size_t j, T& value) const {
+MatrixRef::getItemValue(size_t i, size_t j, T& value) const {
   auto item = getItem(i, j);
   if (item) {
     decode(item, value);
@@ -116,7 +220,7 @@ Matrix::getItemValue(size_t i, size_t j, T& value) const {
 }
 
 inline fbs::Any
-Matrix::getItemType(size_t i, size_t j) const {
+MatrixRef::getItemType(size_t i, size_t j) const {
   auto item = getItem(i, j);
   return item ? item->value_type() : fbs::Any::NONE;
 }
@@ -23,11 +23,31 @@ void MatrixBuilder::finish() {
     return;
   }
   std::vector<flatbuffers::Offset<fbs::Record>> records;
-  for (auto& record : records_) {
-    records.push_back(fbs::CreateRecordDirect(*fbb_, &record));
+  if (compact_ && deadBytes_ > 0) {
+    FBB fbb;
+    for (auto& record : records_) {
+      std::vector<Item> items;
+      for (auto& item : record) {
+        if (item.IsNull()) {
+          items.push_back(item);
+          continue;
+        }
+        auto p = ::flatbuffers::GetTemporaryPointer(*fbb_, item);
+        auto value = copyAligned(fbb, p->value_type(), p->value(),
+                                 vectorAlignment_);
+        items.push_back(fbs::CreateItem(fbb, p->value_type(), value));
+      }
+      records.push_back(fbs::CreateRecordDirect(fbb, &items));
+    }
+    fbb.Finish(fbs::CreateMatrixDirect(fbb, &records));
+    data_ = fbb.Release();
+  } else {
+    for (auto& record : records_) {
+      records.push_back(fbs::CreateRecordDirect(*fbb_, &record));
+    }
+    fbb_->Finish(fbs::CreateMatrixDirect(*fbb_, &records));
+    data_ = fbb_->Release();
   }
-  fbb_->Finish(fbs::CreateMatrixDirect(*fbb_, &records));
-  data_ = fbb_->Release();
   finished_ = true;
 }
 
@@ -68,7 +68,15 @@ class MatrixBuilder : public Builder {
  private:
   void resize(size_t i, size_t j);
 
+  // bookkeeping of sizes_, k and l index records_[k][l]
+  void retire(size_t k, size_t l, size_t mark);
+  void retireRecord(size_t k);
+  void appended(size_t k, size_t mark);
+  void rewritten(size_t n, size_t l, size_t mark);
+
   std::vector<std::vector<Item>> records_;
+  // bytes written for each item, counted as dead once overwritten
+  std::vector<std::vector<uint32_t>> sizes_;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -76,9 +84,45 @@ class MatrixBuilder : public Builder {
 inline void MatrixBuilder::resize(size_t i, size_t j) {
   if (i >= records_.size()) {
     records_.resize(i + 1);
+    sizes_.resize(i + 1);
   }
   if (j >= records_[i].size()) {
     records_[i].resize(j + 1);
+    sizes_[i].resize(j + 1);
+  }
+}
+
+// item (k, l) was rewritten with the bytes written since mark
+inline void MatrixBuilder::retire(size_t k, size_t l, size_t mark) {
+  deadBytes_ += sizes_[k][l];
+  sizes_[k][l] = fbb_->GetSize() - mark;
+}
+
+inline void MatrixBuilder::retireRecord(size_t k) {
+  for (auto size : sizes_[k]) {
+    deadBytes_ += size;
+  }
+  sizes_[k].clear();
+}
+
+// items of record k were appended since mark, one after another
+inline void MatrixBuilder::appended(size_t k, size_t mark) {
+  for (size_t l = sizes_[k].size(); l < records_[k].size(); l++) {
+    sizes_[k].push_back(records_[k][l].o - mark);
+    mark = records_[k][l].o;
+  }
+}
+
+// items (0, l) to (n - 1, l) were rewritten since mark, one after another
+inline void MatrixBuilder::rewritten(size_t n, size_t l, size_t mark) {
+  for (size_t k = 0; k < n; k++) {
+    if (l < sizes_[k].size()) {
+      deadBytes_ += sizes_[k][l];
+    } else {
+      sizes_[k].resize(l + 1);
+    }
+    sizes_[k][l] = records_[k][l].o - mark;
+    mark = records_[k][l].o;
   }
 }
 
@@ -104,7 +148,9 @@ inline void
 MatrixBuilder::setItem(size_t i, size_t j, const fbs::Item* item) {
   assert(item != nullptr);
   resize(i, j);
+  size_t mark = fbb_->GetSize();
   records_[i][j] = copy(*fbb_, *item);
+  retire(i, j, mark);
 }
 
 template <class... Args>
@@ -121,8 +167,11 @@ template <class... Args>
 inline bool
 MatrixBuilder::setRowValue(size_t i, const Args&... args) {
   resize(i, 0);
+  retireRecord(i);
   records_[i].clear();
-  vencodeItems(*fbb_, records_[i], args...);
+  size_t mark = fbb_->GetSize();
+  vencodeItems(*fbb_, records_[i], vectorAlignment_, args...);
+  appended(i, mark);
   return true;
 }
 
@@ -140,7 +189,9 @@ template <class... Args>
 inline bool
 MatrixBuilder::setColValue(size_t j, const Args&... args) {
   resize(sizeof...(Args), 0);
-  vvencodeItems(*fbb_, records_, j, args...);
+  size_t mark = fbb_->GetSize();
+  vvencodeItems(*fbb_, records_, j, vectorAlignment_, args...);
+  rewritten(sizeof...(Args), j, mark);
   return true;
 }
 
@@ -159,8 +210,10 @@ template <class T>
 inline bool
 MatrixBuilder::setItemValue(size_t i, size_t j, const T& value) {
   resize(i, j);
-  auto item = encode(*fbb_, value);
+  size_t mark = fbb_->GetSize();
+  auto item = encodeAligned(*fbb_, value, vectorAlignment_);
   records_[i][j] = fbs::CreateItem(*fbb_, getAnyType<T>(), item.Union());
+  retire(i, j, mark);
   return true;
 }
 
@@ -0,0 +1,435 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flattype/matrix/VectorSearch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FTT_VECTOR_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ftt {
+
+namespace {
+
+typedef float (*DistanceFunc)(const float*, const float*, size_t);
+// <a, b> and |b|^2 in one pass, for cosine
+typedef void (*DotNormFunc)(const float*, const float*, size_t,
+                            float*, float*);
+
+// [0]: unaligned loads, [1]: both operands aligned to `alignment`
+struct Kernels {
+  const char* name;
+  size_t alignment;
+  DistanceFunc dot[2];
+  DistanceFunc l2[2];
+  DotNormFunc dotNorm[2];
+};
+
+float dotScalar(const float* a, const float* b, size_t n) {
+  float s = 0;
+  for (size_t i = 0; i < n; i++) {
+    s += a[i] * b[i];
+  }
+  return s;
+}
+
+float l2Scalar(const float* a, const float* b, size_t n) {
+  float s = 0;
+  for (size_t i = 0; i < n; i++) {
+    float d = a[i] - b[i];
+    s += d * d;
+  }
+  return s;
+}
+
+void dotNormScalar(const float* a, const float* b, size_t n,
+                   float* dot, float* norm) {
+  float s = 0, t = 0;
+  for (size_t i = 0; i < n; i++) {
+    s += a[i] * b[i];
+    t += b[i] * b[i];
+  }
+  *dot = s;
+  *norm = t;
+}
+
+#ifdef FTT_VECTOR_X86
+
+template <bool A>
+__attribute__((target("avx2,fma")))
+inline __m256 load256(const float* p) {
+  return A ? _mm256_load_ps(p) : _mm256_loadu_ps(p);
+}
+
+__attribute__((target("avx2,fma")))
+inline float hsum256(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+  return _mm_cvtss_f32(lo);
+}
+
+template <bool A>
+__attribute__((target("avx2,fma")))
+float dotAvx2(const float* a, const float* b, size_t n) {
+  __m256 s0 = _mm256_setzero_ps();
+  __m256 s1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    s0 = _mm256_fmadd_ps(load256<A>(a + i), load256<A>(b + i), s0);
+    s1 = _mm256_fmadd_ps(load256<A>(a + i + 8), load256<A>(b + i + 8), s1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    s0 = _mm256_fmadd_ps(load256<A>(a + i), load256<A>(b + i), s0);
+  }
+  float s = hsum256(_mm256_add_ps(s0, s1));
+  return s + dotScalar(a + i, b + i, n - i);
+}
+
+template <bool A>
+__attribute__((target("avx2,fma")))
+float l2Avx2(const float* a, const float* b, size_t n) {
+  __m256 s0 = _mm256_setzero_ps();
+  __m256 s1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 d0 = _mm256_sub_ps(load256<A>(a + i), load256<A>(b + i));
+    __m256 d1 = _mm256_sub_ps(load256<A>(a + i + 8), load256<A>(b + i + 8));
+    s0 = _mm256_fmadd_ps(d0, d0, s0);
+    s1 = _mm256_fmadd_ps(d1, d1, s1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    __m256 d0 = _mm256_sub_ps(load256<A>(a + i), load256<A>(b + i));
+    s0 = _mm256_fmadd_ps(d0, d0, s0);
+  }
+  float s = hsum256(_mm256_add_ps(s0, s1));
+  return s + l2Scalar(a + i, b + i, n - i);
+}
+
+template <bool A>
+__attribute__((target("avx2,fma")))
+void dotNormAvx2(const float* a, const float* b, size_t n,
+                 float* dot, float* norm) {
+  __m256 s = _mm256_setzero_ps();
+  __m256 t = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 vb = load256<A>(b + i);
+    s = _mm256_fmadd_ps(load256<A>(a + i), vb, s);
+    t = _mm256_fmadd_ps(vb, vb, t);
+  }
+  float ds, dt;
+  dotNormScalar(a + i, b + i, n - i, &ds, &dt);
+  *dot = hsum256(s) + ds;
+  *norm = hsum256(t) + dt;
+}
+
+template <bool A>
+__attribute__((target("avx512f")))
+inline __m512 load512(const float* p) {
+  return A ? _mm512_load_ps(p) : _mm512_loadu_ps(p);
+}
+
+template <bool A>
+__attribute__((target("avx512f")))
+inline __m512 load512(__mmask16 m, const float* p) {
+  return A ? _mm512_maskz_load_ps(m, p) : _mm512_maskz_loadu_ps(m, p);
+}
+
+__attribute__((target("avx512f")))
+inline __mmask16 tailMask(size_t left) {
+  return left >= 16 ? __mmask16(0xffff) : __mmask16((1u << left) - 1);
+}
+
+__attribute__((target("avx512f")))
+inline float hsum512(__m512 v) {
+  v = _mm512_add_ps(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm512_add_ps(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  __m128 lo = _mm512_castps512_ps128(v);
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+  return _mm_cvtss_f32(lo);
+}
+
+template <bool A>
+__attribute__((target("avx512f")))
+float dotAvx512(const float* a, const float* b, size_t n) {
+  __m512 s0 = _mm512_setzero_ps();
+  __m512 s1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    s0 = _mm512_fmadd_ps(load512<A>(a + i), load512<A>(b + i), s0);
+    s1 = _mm512_fmadd_ps(load512<A>(a + i + 16), load512<A>(b + i + 16), s1);
+  }
+  for (; i < n; i += 16) {
+    __mmask16 m = tailMask(n - i);
+    s0 = _mm512_fmadd_ps(load512<A>(m, a + i), load512<A>(m, b + i), s0);
+  }
+  return hsum512(_mm512_add_ps(s0, s1));
+}
+
+template <bool A>
+__attribute__((target("avx512f")))
+float l2Avx512(const float* a, const float* b, size_t n) {
+  __m512 s0 = _mm512_setzero_ps();
+  __m512 s1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m512 d0 = _mm512_sub_ps(load512<A>(a + i), load512<A>(b + i));
+    __m512 d1 = _mm512_sub_ps(load512<A>(a + i + 16),
+                              load512<A>(b + i + 16));
+    s0 = _mm512_fmadd_ps(d0, d0, s0);
+    s1 = _mm512_fmadd_ps(d1, d1, s1);
+  }
+  for (; i < n; i += 16) {
+    __mmask16 m = tailMask(n - i);
+    __m512 d0 = _mm512_sub_ps(load512<A>(m, a + i), load512<A>(m, b + i));
+    s0 = _mm512_fmadd_ps(d0, d0, s0);
+  }
+  return hsum512(_mm512_add_ps(s0, s1));
+}
+
+template <bool A>
+__attribute__((target("avx512f")))
+void dotNormAvx512(const float* a, const float* b, size_t n,
+                   float* dot, float* norm) {
+  __m512 s = _mm512_setzero_ps();
+  __m512 t = _mm512_setzero_ps();
+  for (size_t i = 0; i < n; i += 16) {
+    __mmask16 m = tailMask(n - i);
+    __m512 vb = load512<A>(m, b + i);
+    s = _mm512_fmadd_ps(load512<A>(m, a + i), vb, s);
+    t = _mm512_fmadd_ps(vb, vb, t);
+  }
+  *dot = hsum512(s);
+  *norm = hsum512(t);
+}
+
+#endif // FTT_VECTOR_X86
+
+Kernels selectKernels() {
+#ifdef FTT_VECTOR_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Kernels{"avx512", 64,
+                   {dotAvx512<false>, dotAvx512<true>},
+                   {l2Avx512<false>, l2Avx512<true>},
+                   {dotNormAvx512<false>, dotNormAvx512<true>}};
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return Kernels{"avx2", 32,
+                   {dotAvx2<false>, dotAvx2<true>},
+                   {l2Avx2<false>, l2Avx2<true>},
+                   {dotNormAvx2<false>, dotNormAvx2<true>}};
+  }
+#endif
+  return Kernels{"scalar", sizeof(float),
+                 {dotScalar, dotScalar},
+                 {l2Scalar, l2Scalar},
+                 {dotNormScalar, dotNormScalar}};
+}
+
+const Kernels& kernels() {
+  static const Kernels k = selectKernels();
+  return k;
+}
+
+struct Scorer {
+  Scorer(Metric m, const float* q, size_t n)
+    : metric(m), query(q), dim(n), k(kernels()) {
+    aligned = isAligned(query, k.alignment);
+    if (metric == Metric::Cosine) {
+      qnorm = std::sqrt(k.dot[aligned](query, query, dim));
+    }
+  }
+
+  float operator()(const float* v) const {
+    // rows encoded with a matching vector alignment take aligned loads
+    int a = aligned && isAligned(v, k.alignment);
+    switch (metric) {
+      case Metric::DotProduct:
+        return -k.dot[a](query, v, dim);
+      case Metric::L2:
+        return k.l2[a](query, v, dim);
+      case Metric::Cosine: {
+        float dot, norm;
+        k.dotNorm[a](query, v, dim, &dot, &norm);
+        float denom = qnorm * std::sqrt(norm);
+        return denom > 0 ? 1 - dot / denom : 1;
+      }
+    }
+    return 0;
+  }
+
+  Metric metric;
+  const float* query;
+  size_t dim;
+  const Kernels& k;
+  bool aligned{false};
+  float qnorm{0};
+};
+
+inline bool closer(const Neighbor& a, const Neighbor& b) {
+  return a.distance < b.distance ||
+    (a.distance == b.distance && a.row < b.row);
+}
+
+// keeps the k closest rows, heap top is the farthest of them
+class TopK {
+ public:
+  explicit TopK(size_t k) : k_(k) {
+    heap_.reserve(k);
+  }
+
+  void push(size_t row, float distance) {
+    Neighbor n{row, distance};
+    if (heap_.size() < k_) {
+      heap_.push_back(n);
+      std::push_heap(heap_.begin(), heap_.end(), closer);
+    } else if (k_ > 0 && closer(n, heap_.front())) {
+      std::pop_heap(heap_.begin(), heap_.end(), closer);
+      heap_.back() = n;
+      std::push_heap(heap_.begin(), heap_.end(), closer);
+    }
+  }
+
+  std::vector<Neighbor>& data() { return heap_; }
+
+ private:
+  size_t k_;
+  std::vector<Neighbor> heap_;
+};
+
+// RowFn: size_t -> const float* (nullptr to skip the row)
+template <class RowFn>
+std::vector<Neighbor> search(size_t rows,
+                             const RowFn& rowAt,
+                             const Scorer& scorer,
+                             const KnnOptions& options) {
+  size_t threads = std::max(size_t(1), std::min(options.threads, rows));
+  std::vector<TopK> partial(threads, TopK(options.k));
+
+  auto worker = [&](size_t t) {
+    size_t b = rows * t / threads;
+    size_t e = rows * (t + 1) / threads;
+    TopK& topk = partial[t];
+    for (size_t i = b; i < e; i++) {
+      const float* v = rowAt(i);
+      if (v) {
+        topk.push(i, scorer(v));
+      }
+    }
+  };
+
+  if (threads == 1) {
+    worker(0);
+  } else {
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; t++) {
+      pool.emplace_back(worker, t);
+    }
+    for (auto& th : pool) {
+      th.join();
+    }
+  }
+
+  std::vector<Neighbor> out;
+  for (auto& topk : partial) {
+    out.insert(out.end(), topk.data().begin(), topk.data().end());
+  }
+  size_t k = std::min(options.k, out.size());
+  std::partial_sort(out.begin(), out.begin() + k, out.end(), closer);
+  out.resize(k);
+  return out;
+}
+
+inline const float* itemVector(const fbs::Item* item, size_t dim) {
+  if (item && item->value_type() == fbs::Any::FloatArray) {
+    auto v = item->value_as_FloatArray()->value();
+    if (v && v->size() == dim) {
+      return v->data();
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+const char* vectorKernelName() {
+  return kernels().name;
+}
+
+float vectorDistance(Metric metric, const float* a, const float* b, size_t n) {
+  return Scorer(metric, a, n)(b);
+}
+
+std::vector<Neighbor> knnSearch(const fbs::Matrix* matrix,
+                                bool columnar,
+                                size_t col,
+                                const float* query,
+                                size_t dim,
+                                const KnnOptions& options) {
+  Scorer scorer(options.metric, query, dim);
+  if (!matrix || !matrix->value()) {
+    return std::vector<Neighbor>();
+  }
+  auto records = matrix->value();
+  if (columnar) {
+    if (col >= records->size()) {
+      return std::vector<Neighbor>();
+    }
+    auto column = records->Get(col)->value();
+    if (!column) {
+      return std::vector<Neighbor>();
+    }
+    return search(
+        column->size(),
+        [&](size_t i) { return itemVector(column->Get(i), dim); },
+        scorer,
+        options);
+  }
+  return search(
+      records->size(),
+      [&](size_t i) -> const float* {
+        auto row = records->Get(i)->value();
+        return row && col < row->size()
+          ? itemVector(row->Get(col), dim) : nullptr;
+      },
+      scorer,
+      options);
+}
+
+std::vector<Neighbor> knnSearch(const float* data,
+                                size_t rows,
+                                const float* query,
+                                size_t dim,
+                                const KnnOptions& options) {
+  Scorer scorer(options.metric, query, dim);
+  return search(
+      rows,
+      [&](size_t i) { return data + i * dim; },
+      scorer,
+      options);
+}
+
+} // namespace ftt
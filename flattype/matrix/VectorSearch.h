@@ -0,0 +1,108 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "flattype/CommonIDLs.h"
+#include "flattype/matrix/ColumnarMatrix.h"
+#include "flattype/matrix/Matrix.h"
+
+namespace ftt {
+
+enum class Metric {
+  DotProduct,
+  L2,
+  Cosine,
+};
+
+/*
+ * Distances are "smaller is closer" for every metric:
+ *   DotProduct: -<q, v>
+ *   L2:         |q - v|^2
+ *   Cosine:     1 - <q, v> / (|q| |v|)
+ */
+struct Neighbor {
+  size_t row;
+  float distance;
+};
+
+struct KnnOptions {
+  Metric metric{Metric::L2};
+  size_t k{10};
+  size_t threads{1};
+};
+
+// the name of the kernel set selected at runtime: avx512, avx2 or scalar
+const char* vectorKernelName();
+
+float vectorDistance(Metric metric, const float* a, const float* b, size_t n);
+
+/*
+ * Brute-force k nearest neighbours over a FloatArray column. The vectors
+ * are scored in place in the flatbuffer, rows of other types or of other
+ * dimensions are skipped. Results are sorted by ascending distance.
+ *
+ * When both the query and a row are aligned for the selected kernels (see
+ * Builder::setVectorAlignment), the row is scored with aligned loads.
+ */
+std::vector<Neighbor> knnSearch(const fbs::Matrix* matrix,
+                                bool columnar,
+                                size_t col,
+                                const float* query,
+                                size_t dim,
+                                const KnnOptions& options);
+
+inline std::vector<Neighbor> knnSearch(const Matrix& matrix,
+                                       size_t col,
+                                       const std::vector<float>& query,
+                                       const KnnOptions& options) {
+  return knnSearch(matrix.get(), false, col,
+                   query.data(), query.size(), options);
+}
+
+inline std::vector<Neighbor> knnSearch(const ColumnarMatrix& matrix,
+                                       size_t col,
+                                       const std::vector<float>& query,
+                                       const KnnOptions& options) {
+  return knnSearch(matrix.get(), true, col,
+                   query.data(), query.size(), options);
+}
+
+/*
+ * Search over a contiguous row-major block of rows * dim floats, e.g. a
+ * single FloatArray cell holding a whole column of embeddings.
+ */
+std::vector<Neighbor> knnSearch(const float* data,
+                                size_t rows,
+                                const float* query,
+                                size_t dim,
+                                const KnnOptions& options);
+
+inline std::vector<Neighbor> knnSearch(const fbs::FloatArray* block,
+                                       const std::vector<float>& query,
+                                       const KnnOptions& options) {
+  if (!block || !block->value()) {
+    return std::vector<Neighbor>();
+  }
+  size_t dim = query.size();
+  size_t rows = dim > 0 ? ftt::size(block) / dim : 0;
+  return knnSearch(block->value()->data(), rows,
+                   query.data(), dim, options);
+}
+
+} // namespace ftt
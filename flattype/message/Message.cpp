@@ -22,38 +22,38 @@
 
 namespace ftt {
 
-std::string Message::toDebugString() const {
+std::string MessageRef::toDebugString() const {
   std::string out;
   if (!get()) {
     return "{}";
   }
   acc::toAppend("{ code:", getCode(),
                 ", message:", getMessage(),
-                ", bdata:", Bucket(getBData()).toDebugString(),
+                ", bdata:", BucketRef(getBData()).toDebugString(),
                 ", jdata:", toPseudoJson(dynamic(fbs::Json::Object, getJData())),
-                ", vdata:", Tuple(getVData()).toDebugString(),
+                ", vdata:", TupleRef(getVData()).toDebugString(),
                 " }",
                 &out);
   return out;
 }
 
-int Message::getCode() const {
+int MessageRef::getCode() const {
   return ptr_ ? ptr_->code() : 0;
 }
 
-std::string Message::getMessage() const {
+std::string MessageRef::getMessage() const {
   return ptr_ ? ptr_->message()->str() : "";
 }
 
-const fbs::Bucket* Message::getBData() const {
+const fbs::Bucket* MessageRef::getBData() const {
   return ptr_ ? ptr_->bdata() : nullptr;
 }
 
-const fbs::Object* Message::getJData() const {
+const fbs::Object* MessageRef::getJData() const {
   return ptr_ ? ptr_->jdata() : nullptr;
 }
 
-const fbs::Tuple* Message::getVData() const {
+const fbs::Tuple* MessageRef::getVData() const {
   return ptr_ ? ptr_->vdata() : nullptr;
 }
 
@@ -21,6 +21,24 @@
 
 namespace ftt {
 
+class MessageRef : public Ref<fbs::Message> {
+ public:
+  MessageRef() {}
+  MessageRef(const fbs::Message* message) : Ref(message) {}
+
+  std::string toDebugString() const;
+
+  int getCode() const;
+  std::string getMessage() const;
+  const fbs::Bucket* getBData() const;
+  const fbs::Object* getJData() const;
+  const fbs::Tuple* getVData() const;
+};
+
+static_assert(sizeof(MessageRef) == sizeof(void*) &&
+              std::is_trivially_copyable<MessageRef>::value,
+              "MessageRef must stay a trivially copyable pointer");
+
 class Message : public Wrapper<fbs::Message> {
  public:
   Message(const fbs::Message* message) : Wrapper(message) {}
@@ -36,13 +54,27 @@ class Message : public Wrapper<fbs::Message> {
   Message(Message&&) = default;
   Message& operator=(Message&&) = default;
 
-  std::string toDebugString() const override;
+  MessageRef ref() const { return MessageRef(ptr_); }
 
-  int getCode() const;
-  std::string getMessage() const;
-  const fbs::Bucket* getBData() const;
-  const fbs::Object* getJData() const;
-  const fbs::Tuple* getVData() const;
+  std::string toDebugString() const override {
+    return ref().toDebugString();
+  }
+
+  int getCode() const {
+    return ref().getCode();
+  }
+  std::string getMessage() const {
+    return ref().getMessage();
+  }
+  const fbs::Bucket* getBData() const {
+    return ref().getBData();
+  }
+  const fbs::Object* getJData() const {
+    return ref().getJData();
+  }
+  const fbs::Tuple* getVData() const {
+    return ref().getVData();
+  }
 };
 
 } // namespace ftt
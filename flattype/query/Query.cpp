@@ -33,13 +33,13 @@ std::string toDebugString(const fbs::Operation* op, CmdNameGetter func) {
     cmd = acc::to<std::string>(op->cmd());
   }
   acc::toAppend("{ cmd:", cmd,
-                ", params:", Tuple(op->params()).toDebugString(),
+                ", params:", TupleRef(op->params()).toDebugString(),
                 " }",
                 &out);
   return out;
 }
 
-std::string Query::toDebugString() const {
+std::string QueryRef::toDebugString(CmdNameGetter func) const {
   std::string out;
   if (!get()) {
     return "{}";
@@ -52,34 +52,34 @@ std::string Query::toDebugString() const {
   size_t e = std::min(getEnd(), getOperationCount());
   for (size_t i = b; i < e; i++) {
     acc::toAppend(i > b ? ", " : "",
-                  ftt::toDebugString(getOperation(i), cmdNameGetter_),
+                  ftt::toDebugString(getOperation(i), func),
                   &out);
   }
   acc::toAppend("] }", &out);
   return out;
 }
 
-uint64_t Query::getKey() const {
+uint64_t QueryRef::getKey() const {
   return ptr_ ? ptr_->key() : std::numeric_limits<uint64_t>::max();
 }
 
-std::string Query::getURI() const {
+std::string QueryRef::getURI() const {
   return ptr_ ? ptr_->uri()->str() : "";
 }
 
-const fbs::Operation* Query::getOperation(size_t i) const {
+const fbs::Operation* QueryRef::getOperation(size_t i) const {
   return ptr_ ? ptr_->operations()->Get(i) : nullptr;
 }
 
-size_t Query::getOperationCount() const {
+size_t QueryRef::getOperationCount() const {
   return ptr_ ? ptr_->operations()->size() : 0;
 }
 
-size_t Query::getBegin() const {
+size_t QueryRef::getBegin() const {
   return ptr_ ? ptr_->opbegin() : 0;
 }
 
-size_t Query::getEnd() const {
+size_t QueryRef::getEnd() const {
   return ptr_ ? ptr_->opend() : std::numeric_limits<size_t>::max();
 }
 
@@ -27,6 +27,32 @@ typedef const char* (*CmdNameGetter)(uint32_t);
 std::string toDebugString(const fbs::Operation* op,
                           CmdNameGetter func = nullptr);
 
+class QueryRef : public Ref<fbs::Query> {
+ public:
+  QueryRef() {}
+  QueryRef(const fbs::Query* query) : Ref(query) {}
+
+  std::string toDebugString(CmdNameGetter func = nullptr) const;
+
+  uint64_t getKey() const;
+  std::string getURI() const;
+
+  size_t getOperationCount() const;
+
+  const fbs::Operation* getOperation(size_t i) const;
+  template <class... Args>
+  void getOperation(size_t i, uint32_t& cmd, Args&... args) const;
+  template <class... Args>
+  void getOperation(size_t i, Operation<Args...>& o) const;
+
+  size_t getBegin() const;
+  size_t getEnd() const;
+};
+
+static_assert(sizeof(QueryRef) == sizeof(void*) &&
+              std::is_trivially_copyable<QueryRef>::value,
+              "QueryRef must stay a trivially copyable pointer");
+
 class Query : public Wrapper<fbs::Query> {
  public:
   Query(const fbs::Query* query, CmdNameGetter func = nullptr)
@@ -47,21 +73,41 @@ class Query : public Wrapper<fbs::Query> {
 
   void setCmdNameGetter(CmdNameGetter func);
 
-  std::string toDebugString() const override;
+  QueryRef ref() const { return QueryRef(ptr_); }
 
-  uint64_t getKey() const;
-  std::string getURI() const;
+  std::string toDebugString() const override {
+    return ref().toDebugString(cmdNameGetter_);
+  }
 
-  size_t getOperationCount() const;
+  uint64_t getKey() const {
+    return ref().getKey();
+  }
+  std::string getURI() const {
+    return ref().getURI();
+  }
 
-  const fbs::Operation* getOperation(size_t i) const;
+  size_t getOperationCount() const {
+    return ref().getOperationCount();
+  }
+
+  const fbs::Operation* getOperation(size_t i) const {
+    return ref().getOperation(i);
+  }
   template <class... Args>
-  void getOperation(size_t i, uint32_t& cmd, Args&... args) const;
+  void getOperation(size_t i, uint32_t& cmd, Args&... args) const {
+    ref().getOperation(i, cmd, args...);
+  }
   template <class... Args>
-  void getOperation(size_t i, Operation<Args...>& o) const;
+  void getOperation(size_t i, Operation<Args...>& o) const {
+    ref().getOperation(i, o);
+  }
 
-  size_t getBegin() const;
-  size_t getEnd() const;
+  size_t getBegin() const {
+    return ref().getBegin();
+  }
+  size_t getEnd() const {
+    return ref().getEnd();
+  }
 
  private:
   CmdNameGetter cmdNameGetter_{nullptr};
@@ -72,14 +118,14 @@ inline void Query::setCmdNameGetter(CmdNameGetter func) {
 }
 
 template <class... Args>
-void Query::getOperation(size_t i, uint32_t& cmd, Args&... args) const {
+void QueryRef::getOperation(size_t i, uint32_t& cmd, Args&... args) const {
   auto op = getOperation(i);
   cmd = op->cmd();
   vdecode(op->params(), args...);
 }
 
 template <class... Args>
-void Query::getOperation(size_t i, Operation<Args...>& o) const {
+void QueryRef::getOperation(size_t i, Operation<Args...>& o) const {
   auto op = getOperation(i);
   o.cmd = op->cmd();
   decode(op->params(), o.params);
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include "flattype/Encoding.h"
+#include "flattype/TupleBuilder.h"
+#include "flattype/Util.h"
+#include "flattype/matrix/ColumnarMatrixBuilder.h"
+#include "flattype/matrix/MatrixBuilder.h"
+
+using namespace ftt;
+
+namespace {
+
+// copy into aligned memory, as an mmapped file would be
+void* alignedCopy(const uint8_t* data, size_t size, size_t alignment) {
+  void* mem = nullptr;
+  if (posix_memalign(&mem, alignment, size) != 0) {
+    return nullptr;
+  }
+  memcpy(mem, data, size);
+  return mem;
+}
+
+// the float arrays of the matrix, copied into 64-byte aligned memory
+template <class Builder, class M>
+void expectAlignedItems(Builder& builder) {
+  builder.finish();
+  void* mem = alignedCopy(builder.data(), builder.size(), 64);
+  ASSERT_TRUE(mem != nullptr);
+  M matrix(reinterpret_cast<const uint8_t*>(mem));
+  for (size_t i = 0; i < matrix.getRowCount(); i++) {
+    for (size_t j = 0; j < matrix.getColCount(); j++) {
+      ASSERT_TRUE(matrix.getItemType(i, j) == fbs::Any::FloatArray);
+      auto p = reinterpret_cast<const fbs::FloatArray*>(
+          matrix.getItem(i, j)->value());
+      EXPECT_TRUE(isAligned(p->value(), 64));
+      acc::Range<const float*> view;
+      EXPECT_TRUE(matrix.getItemValue(i, j, view));
+      EXPECT_EQ(size_t(3), view.size());
+    }
+  }
+  free(mem);
+}
+
+} // namespace
+
+TEST(Alignment, encodeAligned) {
+  std::vector<float> v = {1.0, 2.0, 3.0, 4.0, 5.0};
+  for (size_t alignment : {16, 32, 64}) {
+    ::flatbuffers::FlatBufferBuilder fbb;
+    fbb.Finish(encodeAligned(fbb, v, alignment));
+    auto buf = fbb.Release();
+    void* mem = alignedCopy(buf.data(), buf.size(), alignment);
+    ASSERT_TRUE(mem != nullptr);
+    auto p = ::flatbuffers::GetRoot<fbs::FloatArray>(mem);
+    EXPECT_TRUE(isAligned(p->value(), alignment));
+    acc::Range<const float*> view;
+    decode(p, view);
+    EXPECT_TRUE(isAligned(view, alignment));
+    EXPECT_EQ(v, std::vector<float>(view.begin(), view.end()));
+    free(mem);
+  }
+}
+
+TEST(Alignment, builder) {
+  std::vector<double> v = {1.0, 2.0, 3.0};
+  TupleBuilder builder;
+  builder.setVectorAlignment(64);
+  builder.setItemValue(0, std::string("abc"));
+  builder.setItemValue(1, v);
+  builder.setItemValue(2, int32_t(1));
+  builder.finish();
+  void* mem = alignedCopy(builder.data(), builder.size(), 64);
+  ASSERT_TRUE(mem != nullptr);
+  Tuple tuple(reinterpret_cast<const uint8_t*>(mem));
+  auto p = reinterpret_cast<const fbs::DoubleArray*>(tuple.getItem(1));
+  EXPECT_TRUE(isAligned(p->value(), 64));
+  acc::Range<const double*> view;
+  EXPECT_TRUE(tuple.getItemValue(1, view));
+  EXPECT_EQ(size_t(3), view.size());
+  EXPECT_EQ(3.0, view[2]);
+  free(mem);
+}
+
+TEST(Alignment, matrix) {
+  std::vector<float> v = {1.0, 2.0, 3.0};
+  MatrixBuilder rows;
+  rows.setVectorAlignment(64);
+  rows.setRowValue(0, v, v);
+  rows.setRowValue(1, v, v);
+  expectAlignedItems<MatrixBuilder, Matrix>(rows);
+
+  MatrixBuilder cols;
+  cols.setVectorAlignment(64);
+  cols.setColValue(0, v, v);
+  cols.setColValue(1, v, v);
+  expectAlignedItems<MatrixBuilder, Matrix>(cols);
+}
+
+TEST(Alignment, columnarMatrix) {
+  std::vector<float> v = {1.0, 2.0, 3.0};
+  ColumnarMatrixBuilder rows;
+  rows.setVectorAlignment(64);
+  rows.setRowValue(0, v, v);
+  rows.setRowValue(1, v, v);
+  expectAlignedItems<ColumnarMatrixBuilder, ColumnarMatrix>(rows);
+
+  ColumnarMatrixBuilder cols;
+  cols.setVectorAlignment(64);
+  cols.setColValue(0, v, v);
+  cols.setColValue(1, v, v);
+  expectAlignedItems<ColumnarMatrixBuilder, ColumnarMatrix>(cols);
+}
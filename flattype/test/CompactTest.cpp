@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "flattype/TupleBuilder.h"
+#include "flattype/matrix/MatrixBuilder.h"
+
+using namespace ftt;
+
+TEST(Compact, tuple) {
+  std::string s(1000, 'x');
+  TupleBuilder builder;
+  builder.setCompact(true);
+  builder.setItemValue(0, int32_t(1));
+  builder.setItemValue(1, s);
+  EXPECT_EQ(size_t(0), builder.deadBytes());
+  for (int i = 0; i < 10; i++) {
+    builder.setItemValue(1, s);
+  }
+  EXPECT_GE(builder.deadBytes(), 10 * s.size());
+  builder.finish();
+  EXPECT_LT(builder.size(), 2 * s.size());
+
+  Tuple tuple(builder.data());
+  int32_t a;
+  std::string b;
+  EXPECT_TRUE(tuple.getValue(a, b));
+  EXPECT_EQ(1, a);
+  EXPECT_EQ(s, b);
+}
+
+TEST(Compact, matrix) {
+  std::string s(1000, 'x');
+  MatrixBuilder builder;
+  builder.setCompact(true);
+  builder.setRowValue(0, int32_t(1), s);
+  builder.setRowValue(1, int32_t(2), s);
+  builder.setRowValue(0, int32_t(3), s);
+  builder.setItemValue(1, 1, std::string("abc"));
+  EXPECT_GE(builder.deadBytes(), 2 * s.size());
+  builder.finish();
+  EXPECT_LT(builder.size(), 2 * s.size());
+
+  Matrix matrix(builder.data());
+  int32_t a;
+  std::string b;
+  EXPECT_TRUE(matrix.getRowValue(0, a, b));
+  EXPECT_EQ(3, a);
+  EXPECT_EQ(s, b);
+  EXPECT_TRUE(matrix.getRowValue(1, a, b));
+  EXPECT_EQ(2, a);
+  EXPECT_EQ("abc", b);
+}
+
+TEST(Compact, sharedFBB) {
+  FBB fbb;
+  TupleBuilder shared(&fbb);
+  EXPECT_THROW(shared.setCompact(true), std::invalid_argument);
+  EXPECT_FALSE(shared.getCompact());
+  shared.setCompact(false);
+
+  MatrixBuilder owned(new FBB(), true);
+  owned.setCompact(true);
+  EXPECT_TRUE(owned.getCompact());
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Lookup latency of HashMap64 against CuckooHashMap64 at several load
+ * factors, for hits and misses, one find() at a time and by findBatch().
+ * Not a test, build with -DFTT_BENCHMARK=ON and run it on a quiet host.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "flattype/hash/CuckooHashMapBuilder.h"
+#include "flattype/hash/HashMapBuilder.h"
+
+using namespace ftt;
+
+namespace {
+
+const size_t kBuckets = size_t(1) << 18;     // 1M cuckoo slots
+const size_t kQueries = size_t(1) << 22;
+const int kRounds = 5;
+
+// best of kRounds, in ns per key
+template <class F>
+double timeLookups(F&& f) {
+  double best = 0;
+  for (int r = 0; r < kRounds; r++) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> t =
+      std::chrono::steady_clock::now() - start;
+    double ns = t.count() / kQueries;
+    if (r == 0 || ns < best) {
+      best = ns;
+    }
+  }
+  return best;
+}
+
+template <class Map>
+void run(const char* name, float loadFactor, const Map& hmap,
+         const std::vector<uint64_t>& hits,
+         const std::vector<uint64_t>& misses) {
+  std::vector<typename Map::const_iterator> out(kQueries, hmap.cend());
+  size_t found = 0;
+  for (auto* keys : {&hits, &misses}) {
+    double find = timeLookups([&]() {
+      for (auto key : *keys) {
+        found += hmap.find(key) != hmap.cend();
+      }
+    });
+    double batch = timeLookups([&]() {
+      hmap.findBatch(keys->data(), keys->size(), out.data());
+      found += out.back() != hmap.cend();
+    });
+    std::printf("%-16s %.2f %-6s find %7.2f ns  findBatch %7.2f ns\n",
+                name, loadFactor, keys == &hits ? "hit" : "miss",
+                find, batch);
+  }
+  if (found == size_t(-1)) {
+    std::printf("\n");   // keep the lookups
+  }
+}
+
+} // namespace
+
+int main() {
+  for (float loadFactor : {0.5f, 0.7f, 0.9f}) {
+    // the cuckoo table keeps kBuckets buckets for n keys up to 0.95 load
+    size_t n = size_t(loadFactor * kBuckets * 4);
+    std::vector<fbs::HSlot64T> entries(n);
+    CuckooHashMap64Builder cbuilder(0);
+    cbuilder.init(n, 0.95f);
+    for (size_t i = 0; i < n; i++) {
+      entries[i].key = hashInt(i);
+      entries[i].indexes = {i};
+      cbuilder.findOrConstruct(entries[i].key, {i});
+    }
+    HashMap64Builder hbuilder(0);
+    hbuilder.build(std::move(entries), loadFactor);
+
+    // the keys hashInt(i) are distinct, so i >= n are all misses
+    std::vector<uint64_t> hits(kQueries);
+    std::vector<uint64_t> misses(kQueries);
+    for (size_t i = 0; i < kQueries; i++) {
+      hits[i] = hashInt(hashInt(i + 1) % n);
+      misses[i] = hashInt(n + i);
+    }
+
+    HashMap64 hmap = hbuilder.toHashMap();
+    CuckooHashMap64 cmap = cbuilder.toHashMap();
+    run("HashMap64", loadFactor, hmap, hits, misses);
+    run("CuckooHashMap64", loadFactor, cmap, hits, misses);
+  }
+  return 0;
+}
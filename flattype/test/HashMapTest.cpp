@@ -0,0 +1,515 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <set>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include "accelerator/Conv.h"
+#include "flattype/hash/CuckooHashMapBuilder.h"
+#include "flattype/hash/FlatHashMapBuilder.h"
+#include "flattype/hash/HashMapBuilder.h"
+#include "flattype/hash/HashMapStats.h"
+#include "flattype/hash/PerfectHashMapBuilder.h"
+#include "flattype/hash/ShardedHashMapBuilder.h"
+#include "flattype/hash/SlotCounters.h"
+#include "flattype/hash/SwissHashMapBuilder.h"
+#include "flattype/index/IndexBuilder.h"
+
+using namespace ftt;
+
+// the open addressing formats share one builder and lookup API, so they
+// are checked by the same typed tests
+template <class B, class SB, class IB, fbs::HMap T>
+struct MapFormat {
+  typedef B Builder;
+  typedef SB StringBuilder;
+  typedef IB IndexBuilder;
+  static fbs::HMap hashType() { return T; }
+};
+
+template <class F>
+class MapFormatTest : public ::testing::Test {};
+
+typedef ::testing::Types<
+  MapFormat<FlatHashMap64Builder, FlatHashMapSBuilder,
+            FlatIndexSBuilder, fbs::HMap::FHMapS>,
+  MapFormat<SwissHashMap32Builder, SwissHashMapSBuilder,
+            SwissIndexSBuilder, fbs::HMap::SHMapS>,
+  MapFormat<PerfectHashMap64Builder, PerfectHashMapSBuilder,
+            PerfectIndexSBuilder, fbs::HMap::PHMapS>,
+  MapFormat<CuckooHashMap64Builder, CuckooHashMapSBuilder,
+            CuckooIndexSBuilder, fbs::HMap::CHMapS>> MapFormats;
+TYPED_TEST_CASE(MapFormatTest, MapFormats);
+
+TYPED_TEST(MapFormatTest, find) {
+  typedef typename TypeParam::Builder Builder;
+  typedef typename Builder::key_type K;
+  Builder builder(10);
+  for (K i = 0; i < 10000; i++) {
+    EXPECT_TRUE(builder.findOrConstruct(i * 7, {uint64_t(i)}).second);
+  }
+  EXPECT_FALSE(builder.findOrConstruct(K(7), {0}).second);
+  EXPECT_EQ(size_t(10000), builder.size());
+  EXPECT_EQ(K(7), builder.find(K(7))->key);
+  EXPECT_TRUE(builder.find(K(8)) == builder.cend());
+
+  auto hmap = builder.toHashMap();
+  EXPECT_EQ(size_t(10000), hmap.size());
+  std::vector<K> keys;
+  for (K i = 0; i < 10000; i++) {
+    auto it = hmap.find(i * 7);
+    ASSERT_TRUE(it != hmap.cend());
+    EXPECT_EQ(i * 7, it->key());
+    EXPECT_EQ(uint64_t(i), it->indexes()->Get(0));
+    EXPECT_TRUE(hmap.find(i * 7 + 1) == hmap.cend());
+    keys.push_back(i * 7 + i % 2);
+  }
+  std::vector<typename decltype(hmap)::const_iterator> out(keys.size());
+  hmap.findBatch(keys.data(), keys.size(), out.data());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_TRUE(out[i] == hmap.find(keys[i]));
+    EXPECT_EQ(i % 2 == 0, out[i] != hmap.cend());
+  }
+  size_t n = 0;
+  for (auto it = hmap.cbegin(); it != hmap.cend(); ++it) {
+    n++;
+  }
+  EXPECT_EQ(size_t(10000), n);
+}
+
+TYPED_TEST(MapFormatTest, index) {
+  FBB fbb;
+  typename TypeParam::IndexBuilder builder(&fbb);
+  builder.setName("test");
+  typename TypeParam::StringBuilder hbuilder(100, &fbb);
+  for (int i = 0; i < 1000; i++) {
+    hbuilder.findOrConstruct(acc::to<std::string>("key", i), {uint64_t(i)});
+  }
+  builder.buildHash([&](FBB*) { return hbuilder.create().Union(); });
+
+  auto index = builder.toIndex();
+  EXPECT_EQ("test", index.getName());
+  EXPECT_EQ(TypeParam::hashType(), index.getHashType());
+  std::vector<acc::StringPiece> keys;
+  std::vector<std::string> names;
+  for (int i = 0; i < 1100; i++) {
+    names.push_back(acc::to<std::string>("key", i));
+  }
+  for (auto& name : names) {
+    keys.push_back(name);
+  }
+  std::vector<typename decltype(index)::const_iterator> out(keys.size());
+  index.findBatch(keys.data(), keys.size(), out.data());
+  for (int i = 0; i < 1100; i++) {
+    auto it = index.find(names[i]);
+    EXPECT_TRUE(it == out[i]);
+    ASSERT_EQ(i < 1000, it != index.end());
+    if (i < 1000) {
+      EXPECT_EQ(names[i], it->key()->str());
+      EXPECT_EQ(uint64_t(i), it->indexes()->Get(0));
+    }
+  }
+}
+
+TEST(HashMap, int64) {
+  HashMap64Builder builder(1000);
+  for (uint64_t i = 1; i <= 1000; i++) {
+    EXPECT_TRUE(builder.findOrConstruct(i * 7, {i}).second);
+  }
+  EXPECT_FALSE(builder.findOrConstruct(7, {0}).second);
+  EXPECT_EQ(uint64_t(7), builder.find(7)->key());
+  EXPECT_TRUE(builder.find(8) == builder.cend());
+
+  HashMap64 hmap = builder.toHashMap();
+  for (uint64_t i = 1; i <= 1000; i++) {
+    auto it = hmap.find(i * 7);
+    ASSERT_TRUE(it != hmap.cend());
+    EXPECT_EQ(i * 7, it->key());
+    EXPECT_EQ(i, it->indexes()->Get(0));
+    EXPECT_TRUE(hmap.find(i * 7 + 1) == hmap.cend());
+  }
+  size_t n = 0;
+  for (auto it = hmap.cbegin(); it != hmap.cend(); ++it) {
+    n++;
+  }
+  EXPECT_EQ(size_t(1000), n);
+}
+
+TEST(HashMap, string) {
+  HashMapSBuilder builder(100);
+  for (int i = 0; i < 100; i++) {
+    builder.findOrConstruct(acc::to<std::string>("key", i), {uint64_t(i)});
+  }
+  EXPECT_FALSE(builder.findOrConstruct("key1", {}).second);
+  EXPECT_EQ(uint16_t(slotFingerprint(hashKey(std::string("key1")))),
+            builder.find("key1")->fp());
+
+  HashMapS hmap = builder.toHashMap();
+  size_t n = 0;
+  for (auto it = hmap.cbegin(); it != hmap.cend(); ++it) {
+    EXPECT_TRUE(hmap.find(acc::StringPiece(it->key()->str())) == it);
+    n++;
+  }
+  EXPECT_EQ(size_t(100), n);
+  EXPECT_TRUE(hmap.find("key1") != hmap.cend());
+  EXPECT_TRUE(hmap.find("key100") == hmap.cend());
+}
+
+TEST(HashMap, legacyHash) {
+  std::vector<fbs::HSlot64T> entries;
+  HashMap64Builder builder(1000);
+  builder.setHashType(fbs::HashType::Legacy);
+  HashMap64Builder bulk(0);
+  bulk.setHashType(fbs::HashType::Legacy);
+  for (uint64_t i = 0; i < 1000; i++) {
+    builder.findOrConstruct(i, {i});
+    fbs::HSlot64T entry;
+    entry.key = i;
+    entry.indexes = {i};
+    entries.push_back(std::move(entry));
+  }
+  EXPECT_THROW(builder.setHashType(fbs::HashType::Murmur),
+               std::runtime_error);
+  bulk.build(std::move(entries));
+
+  for (auto* b : {&builder, &bulk}) {
+    HashMap64 hmap = b->toHashMap();
+    EXPECT_TRUE(hmap.getHashType() == fbs::HashType::Legacy);
+    // the identity hash of keys < 2^48 must not give them all one
+    // fingerprint
+    std::set<uint16_t> fps;
+    for (uint64_t i = 0; i < 1000; i++) {
+      auto it = hmap.find(i);
+      ASSERT_TRUE(it != hmap.cend());
+      EXPECT_EQ(i, it->indexes()->Get(0));
+      fps.insert(it->fp());
+    }
+    EXPECT_GT(fps.size(), size_t(950));
+    EXPECT_TRUE(hmap.find(1000) == hmap.cend());
+  }
+}
+
+TEST(HashMap, findBatch) {
+  HashMap64Builder builder(1000);
+  for (uint64_t i = 1; i <= 1000; i++) {
+    builder.findOrConstruct(i, {i});
+  }
+  HashMap64 hmap = builder.toHashMap();
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1100; i++) {
+    keys.push_back(i);
+  }
+  std::vector<HashMap64::const_iterator> out(keys.size());
+  hmap.findBatch(keys.data(), keys.size(), out.data());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_TRUE(out[i] == hmap.find(keys[i]));
+    EXPECT_EQ(i >= 1 && i <= 1000, out[i] != hmap.cend());
+  }
+}
+
+TEST(HashMap, stats) {
+  HashMap64Builder builder(1000);
+  for (uint64_t i = 0; i < 1000; i++) {
+    builder.findOrConstruct(i, {i});
+  }
+  HashMapStats built = hashMapStats(builder);
+
+  HashMap64 hmap = builder.toHashMap();
+  HashMapStats stats = hashMapStats(hmap);
+  EXPECT_EQ(hmap.slotCount(), stats.slots);
+  EXPECT_EQ(size_t(1000), stats.keys);
+  EXPECT_EQ(built.keys, stats.keys);
+  EXPECT_TRUE(built.chains == stats.chains);
+  EXPECT_EQ(stats.slots - 1000 - 1, stats.emptySlots);
+  EXPECT_NEAR(1000.0 / stats.slots, stats.loadFactor(), 1e-9);
+
+  size_t homes = 0;
+  size_t keys = 0;
+  for (size_t n = 0; n < stats.chains.size(); n++) {
+    homes += stats.chains[n];
+    keys += n * stats.chains[n];
+  }
+  EXPECT_EQ(stats.slots, homes);
+  EXPECT_EQ(stats.keys, keys);
+  EXPECT_GE(stats.meanHitProbes, 1.0);
+  EXPECT_EQ(stats.chains.size() - 1, stats.maxHitProbes);
+  EXPECT_EQ(size_t(8000), stats.keyBytes);
+  EXPECT_EQ(size_t(16000), stats.indexBytes);
+  EXPECT_GT(stats.bytesPerKey(), 24.0);
+  EXPECT_FALSE(stats.toString().empty());
+
+  for (uint64_t i = 0; i < 6400; i++) {
+    hmap.find(i % 2000);
+  }
+  LookupStats lookups = hmap.lookupStats();
+  EXPECT_LE(lookups.sampled, uint64_t(6400));
+  EXPECT_LE(lookups.hits, lookups.sampled);
+  EXPECT_LE(lookups.meanHitProbes(), double(lookups.maxProbes));
+}
+
+TEST(HashMap, build) {
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 1000; i++) {
+    keys.push_back(acc::to<std::string>("key", i));
+  }
+  keys.push_back("key7");
+
+  std::vector<std::vector<std::string>> layouts;
+  for (int round = 0; round < 2; round++) {
+    std::vector<fbs::HSlotST> entries;
+    for (size_t i = 0; i < keys.size(); i++) {
+      fbs::HSlotST entry;
+      entry.key = keys[i];
+      entry.indexes = {uint64_t(i)};
+      entries.push_back(std::move(entry));
+    }
+    HashMapSBuilder builder(0);
+    builder.build(std::move(entries), 0.95f);
+    EXPECT_THROW(builder.findOrConstruct("key", {}), std::runtime_error);
+
+    HashMapS hmap = builder.toHashMap();
+    for (uint64_t i = 0; i < 1000; i++) {
+      auto it = hmap.find(keys[i]);
+      ASSERT_TRUE(it != hmap.cend());
+      EXPECT_EQ(keys[i], it->key()->str());
+      EXPECT_EQ(i, it->indexes()->Get(0));
+    }
+    EXPECT_TRUE(hmap.find("key1000") == hmap.cend());
+
+    std::vector<std::string> layout;
+    for (auto it = hmap.cbegin(); it != hmap.cend(); ++it) {
+      layout.push_back(it->key()->str());
+    }
+    EXPECT_EQ(size_t(1000), layout.size());
+    layouts.push_back(layout);
+  }
+  EXPECT_TRUE(layouts[0] == layouts[1]);
+}
+
+TEST(HashMap, inlineValue) {
+  std::vector<fbs::HSlot64T> entries;
+  for (uint64_t i = 0; i < 100; i++) {
+    fbs::HSlot64T entry;
+    entry.key = i;
+    if (i % 2 == 0) {
+      setInlineValue(entry, i * 1000000007);
+    } else {
+      setInlineValue(entry, i * 0.5);
+    }
+    entries.push_back(std::move(entry));
+  }
+  HashMap64Builder builder(0);
+  builder.build(std::move(entries));
+
+  HashMap64 hmap = builder.toHashMap();
+  for (uint64_t i = 0; i < 100; i++) {
+    auto it = hmap.find(i);
+    ASSERT_TRUE(it != hmap.cend());
+    EXPECT_TRUE(hasInlineValue(&*it));
+    if (i % 2 == 0) {
+      uint64_t value = 0;
+      decode(&*it, value);
+      EXPECT_EQ(i * 1000000007, value);
+    } else {
+      double value = 0;
+      decode(&*it, value);
+      EXPECT_EQ(i * 0.5, value);
+    }
+  }
+}
+
+TEST(HashMap, counters) {
+  HashMap64Builder builder(1000);
+  builder.setCounterColumns(2);
+  for (uint64_t i = 0; i < 1000; i++) {
+    builder.findOrConstruct(i, {i});
+  }
+  builder.finish();
+  auto data = builder.detachedData();
+  HashMap64 hmap(data.data());
+  SlotCounters64 counters(data.data());
+  EXPECT_EQ(size_t(2), counters.columns());
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      for (uint64_t i = 0; i < 1000; i++) {
+        uint32_t slot = hmap.find(i).slot();
+        counters.fetchAdd(slot, 0, 1);
+        counters.fetchMax(slot, 1, t * 1000 + i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (uint64_t i = 0; i < 1000; i++) {
+    uint32_t slot = hmap.find(i).slot();
+    EXPECT_EQ(uint64_t(4), counters.load(slot, 0));
+    EXPECT_EQ(3000 + i, counters.load(slot, 1));
+  }
+  counters.store(hmap.find(7).slot(), 0, 0);
+  EXPECT_EQ(uint64_t(0), counters.load(hmap.find(7).slot()));
+  EXPECT_THROW(counters.load(0, 2), std::out_of_range);
+
+  HashMap64Builder plain(10);
+  plain.finish();
+  auto plainData = plain.detachedData();
+  EXPECT_THROW(SlotCounters64 none(plainData.data()), std::runtime_error);
+}
+
+TEST(CuckooHashMap, stash) {
+  CuckooHashMap64Builder builder(10);
+  for (uint64_t i = 0; i < 100000; i++) {
+    builder.findOrConstruct(i * 7, {i});
+  }
+  CuckooHashMap64 hmap = builder.toHashMap();
+  EXPECT_EQ(size_t(100000), hmap.size());
+  EXPECT_LE(hmap.stashSize(), size_t(4));
+  for (uint64_t i = 0; i < 100000; i++) {
+    auto it = hmap.find(i * 7);
+    ASSERT_TRUE(it != hmap.cend());
+    EXPECT_EQ(i, it->indexes()->Get(0));
+  }
+}
+
+TEST(PerfectHashMap, layout) {
+  std::vector<uint64_t> hashes;
+  for (uint64_t i = 0; i < 10000; i++) {
+    hashes.push_back(hashInt(i));
+  }
+  PerfectHashLayout layout = buildPerfectHash(hashes);
+  ASSERT_EQ(hashes.size(), layout.positions.size());
+  std::vector<bool> taken(hashes.size());
+  for (uint32_t p : layout.positions) {
+    ASSERT_LT(p, uint32_t(hashes.size()));
+    EXPECT_FALSE(taken[p]);
+    taken[p] = true;
+  }
+  for (uint32_t p : layout.remap) {
+    EXPECT_LT(p, uint32_t(hashes.size()));
+  }
+  EXPECT_TRUE(buildPerfectHash({}).pilots.empty());
+  hashes.push_back(hashes[0]);
+  EXPECT_THROW(buildPerfectHash(hashes), std::runtime_error);
+}
+
+TEST(ShardedHashMap, int64) {
+  std::vector<fbs::HSlot64T> entries;
+  for (uint64_t i = 0; i < 10000; i++) {
+    fbs::HSlot64T entry;
+    entry.key = i * 7;
+    entry.indexes = {i};
+    entries.push_back(std::move(entry));
+  }
+  ShardedHashMap64Builder builder(4);
+  builder.build(std::move(entries), 4);
+
+  EXPECT_EQ(uint64_t(10000), builder.size());
+
+  ShardedHashMap64 hmap = builder.toHashMap();
+  EXPECT_EQ(size_t(16), hmap.shardCount());
+  EXPECT_EQ(uint64_t(10000), hmap.size());
+  for (uint64_t i = 0; i < 10000; i++) {
+    auto it = hmap.find(i * 7);
+    ASSERT_TRUE(it != hmap.cend());
+    EXPECT_EQ(i * 7, it->key());
+    EXPECT_EQ(i, it->indexes()->Get(0));
+    EXPECT_TRUE(hmap.find(i * 7 + 1) == hmap.cend());
+  }
+  size_t n = 0;
+  for (auto it = hmap.cbegin(); it != hmap.cend(); ++it) {
+    n++;
+  }
+  EXPECT_EQ(size_t(10000), n);
+}
+
+TEST(ShardedHashMap, detachShard) {
+  ShardedHashMapSBuilder builder(2);
+  std::vector<std::vector<fbs::HSlotST>> parts(4);
+  for (int i = 0; i < 1000; i++) {
+    fbs::HSlotST entry;
+    entry.key = acc::to<std::string>("key", i);
+    entry.indexes = {uint64_t(i)};
+    parts[hashToShard(hashKey(entry.key), 2)].push_back(std::move(entry));
+  }
+  std::vector<::flatbuffers::DetachedBuffer> stored;
+  for (size_t i = 0; i < 4; i++) {
+    builder.buildShard(i, std::move(parts[i]));
+    stored.push_back(builder.detachShard(i));
+  }
+
+  ShardedHashMapS hmap = builder.toHashMap();
+  EXPECT_EQ(uint64_t(1000), hmap.size());
+  EXPECT_FALSE(hmap.hasShard(0));
+  EXPECT_TRUE(hmap.cbegin() == hmap.cend());
+  EXPECT_THROW(hmap.find("key0"), std::runtime_error);
+
+  for (size_t i = 0; i < 4; i++) {
+    hmap.setShard(i, stored[i].data());
+  }
+  for (int i = 0; i < 1000; i++) {
+    auto key = acc::to<std::string>("key", i);
+    auto it = hmap.find(key);
+    ASSERT_TRUE(it != hmap.cend());
+    EXPECT_EQ(uint64_t(i), it->indexes()->Get(0));
+  }
+  EXPECT_TRUE(hmap.find("key1000") == hmap.cend());
+}
+
+TEST(HashMap, forEachRange) {
+  HashMap64Builder builder(1000);
+  for (uint64_t i = 0; i < 1000; i++) {
+    builder.findOrConstruct(i * 7, {i});
+  }
+  HashMap64 hmap = builder.toHashMap();
+  EXPECT_EQ(size_t(1000), hmap.scanSize());
+  uint64_t next = 0;
+  hmap.forEachRange(0, 500, [&](const fbs::HSlot64& slot) {
+    EXPECT_EQ(next * 7, slot.key());
+    next++;
+  });
+  hmap.forEachRange(500, 2000, [&](const fbs::HSlot64& slot) {
+    EXPECT_EQ(next * 7, slot.key());
+    next++;
+  });
+  EXPECT_EQ(uint64_t(1000), next);
+}
+
+TEST(HashMap, parallelForEach) {
+  FBB fbb;
+  ShardedIndex64Builder builder(&fbb);
+  builder.setName("test");
+  ShardedHashMap64Builder hbuilder(3, &fbb);
+  std::vector<fbs::HSlot64T> entries;
+  for (uint64_t i = 1; i <= 10000; i++) {
+    fbs::HSlot64T entry;
+    entry.key = i;
+    entries.push_back(std::move(entry));
+  }
+  hbuilder.build(std::move(entries), 2);
+  builder.buildHash([&](FBB*) { return hbuilder.create().Union(); });
+
+  ShardedIndex64 index = builder.toIndex();
+  EXPECT_EQ(size_t(10000), index.scanSize());
+  std::atomic<uint64_t> sum(0);
+  index.parallelForEach(4, [&](const fbs::HSlot64& slot) {
+    sum += slot.key();
+  });
+  EXPECT_EQ(uint64_t(10000 * 10001 / 2), sum.load());
+}
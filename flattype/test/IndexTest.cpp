@@ -0,0 +1,322 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include "flattype/SnapshotHolder.h"
+#include "accelerator/Conv.h"
+#include "flattype/hash/HashMapBuilder.h"
+#include "flattype/hash/OrderedMapBuilder.h"
+#include "flattype/hash/PerfectHashMapBuilder.h"
+#include "flattype/index/IndexBuilder.h"
+#include "flattype/index/IndexMerge.h"
+#include "flattype/index/LayeredIndex.h"
+
+using namespace ftt;
+
+namespace {
+
+std::unique_ptr<Index64> makeIndex(std::vector<fbs::HSlot64T>&& entries) {
+  FBB fbb;
+  Index64Builder builder(&fbb);
+  HashMap64Builder hbuilder(0, &fbb);
+  hbuilder.build(std::move(entries));
+  builder.buildHash([&](FBB*) { return hbuilder.create().Union(); });
+  return std::unique_ptr<Index64>(new Index64(builder.toIndex()));
+}
+
+fbs::HSlot64T makeEntry(uint64_t key, uint64_t index, bool deleted = false) {
+  fbs::HSlot64T entry;
+  entry.key = key;
+  entry.indexes = {index};
+  entry.deleted = deleted;
+  return entry;
+}
+
+uint64_t findIndex(const LayeredIndex<Index64>& index, uint64_t key) {
+  auto snapshot = index.snapshot();
+  auto slot = snapshot->find(key);
+  return slot ? slot->indexes()->Get(0) : uint64_t(-1);
+}
+
+} // namespace
+
+TEST(LayeredIndex, find) {
+  std::vector<fbs::HSlot64T> entries;
+  for (uint64_t i = 0; i < 1000; i++) {
+    entries.push_back(makeEntry(i, i));
+  }
+  LayeredIndex<Index64> index(makeIndex(std::move(entries)));
+
+  std::vector<fbs::HSlot64T> delta1;
+  delta1.push_back(makeEntry(5, 500));
+  delta1.push_back(makeEntry(7, 0, true));
+  delta1.push_back(makeEntry(2000, 2000));
+  index.addLayer(makeIndex(std::move(delta1)));
+
+  std::vector<fbs::HSlot64T> delta2;
+  delta2.push_back(makeEntry(8, 0, true));
+  delta2.push_back(makeEntry(7, 70));
+  delta2.push_back(makeEntry(2000, 0, true));
+  index.addLayer(makeIndex(std::move(delta2)));
+
+  auto check = [&]() {
+    EXPECT_EQ(uint64_t(1), findIndex(index, 1));
+    EXPECT_EQ(uint64_t(500), findIndex(index, 5));
+    EXPECT_EQ(uint64_t(70), findIndex(index, 7));
+    EXPECT_EQ(uint64_t(-1), findIndex(index, 8));
+    EXPECT_EQ(uint64_t(-1), findIndex(index, 2000));
+    EXPECT_EQ(uint64_t(-1), findIndex(index, 3000));
+  };
+  check();
+  // a copy outlives the guard and the merge
+  const LayeredIndex<Index64>::Snapshot old = *index.snapshot();
+  EXPECT_EQ(size_t(2), old.layerCount());
+
+  LayeredIndex<Index64>::Compactor compact =
+    [](std::vector<fbs::HSlot64T>&& merged) {
+      return makeIndex(std::move(merged));
+    };
+  index.merge(compact);
+  check();
+  EXPECT_EQ(size_t(0), index.snapshot()->layerCount());
+  EXPECT_EQ(size_t(999), index.snapshot()->base().scanSize());
+  EXPECT_EQ(uint64_t(70), old.find(7)->indexes()->Get(0));
+
+  std::vector<fbs::HSlot64T> delta3;
+  delta3.push_back(makeEntry(3000, 3000));
+  index.addLayer(makeIndex(std::move(delta3)));
+  index.mergeAsync(compact);
+  std::vector<fbs::HSlot64T> delta4;
+  delta4.push_back(makeEntry(1, 100));
+  index.addLayer(makeIndex(std::move(delta4)));
+  index.waitMerge();
+  EXPECT_EQ(uint64_t(3000), findIndex(index, 3000));
+  EXPECT_EQ(uint64_t(100), findIndex(index, 1));
+  EXPECT_EQ(uint64_t(70), findIndex(index, 7));
+}
+
+TEST(SnapshotHolder, publish) {
+  auto makeGeneration = [](uint64_t generation) {
+    std::vector<fbs::HSlot64T> entries;
+    for (uint64_t i = 0; i < 100; i++) {
+      entries.push_back(makeEntry(i, generation));
+    }
+    return makeIndex(std::move(entries));
+  };
+  SnapshotHolder<Index64> holder(makeGeneration(0));
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> errors{0};
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < 4; t++) {
+    readers.emplace_back([&]() {
+      uint64_t last = 0;
+      while (!done) {
+        auto index = holder.read();
+        uint64_t generation = index->find(1)->indexes()->Get(0);
+        for (uint64_t i = 0; i < 100; i++) {
+          if (index->find(i)->indexes()->Get(0) != generation) {
+            errors++;
+          }
+        }
+        if (generation < last) {
+          errors++;
+        }
+        last = generation;
+      }
+    });
+  }
+  for (uint64_t g = 1; g <= 50; g++) {
+    holder.publish(makeGeneration(g));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(size_t(0), errors.load());
+  EXPECT_EQ(uint64_t(50), holder.read()->find(7)->indexes()->Get(0));
+}
+
+TEST(OrderedMap, int64) {
+  std::vector<uint64_t> keys;
+  OrderedMap64Builder builder(3000);
+  for (uint64_t i = 0; i < 3000; i++) {
+    uint64_t key = i < 2000 ? i * i : (uint64_t(1) << 40) + i * 7;
+    keys.push_back(key);
+    builder.findOrConstruct(key, {i});
+  }
+  EXPECT_FALSE(builder.findOrConstruct(9, {}).second);
+  std::sort(keys.begin(), keys.end());
+
+  OrderedMap64 omap = builder.toOrderedMap();
+  EXPECT_EQ(size_t(3000), omap.size());
+  uint64_t prev = 0;
+  size_t n = 0;
+  for (auto it = omap.cbegin(); it != omap.cend(); ++it, n++) {
+    EXPECT_TRUE(n == 0 || prev < it->key());
+    prev = it->key();
+  }
+  EXPECT_EQ(size_t(3000), n);
+
+  for (uint64_t q = 0; q < 5000000; q += 997) {
+    for (uint64_t key : {q, (uint64_t(1) << 40) + q % 30000}) {
+      size_t rank = std::lower_bound(keys.begin(), keys.end(), key)
+        - keys.begin();
+      EXPECT_EQ(rank, omap.lower_bound(key).rank());
+      size_t upper = std::upper_bound(keys.begin(), keys.end(), key)
+        - keys.begin();
+      EXPECT_EQ(upper, omap.upper_bound(key).rank());
+      EXPECT_EQ(rank != upper, omap.find(key) != omap.cend());
+    }
+  }
+  EXPECT_EQ(uint64_t(3), omap.find(9)->indexes()->Get(0));
+  auto range = omap.range(100, 10000);
+  EXPECT_EQ(uint32_t(10), range.first.rank());
+  EXPECT_EQ(uint32_t(100), range.second.rank());
+  range = omap.range(10000, 100);
+  EXPECT_TRUE(range.first == range.second);
+}
+
+TEST(OrderedMap, index) {
+  FBB fbb;
+  OrderedIndexSBuilder builder(&fbb);
+  builder.setName("test");
+  OrderedMapSBuilder obuilder(1000, &fbb);
+  for (int i = 0; i < 1000; i++) {
+    obuilder.findOrConstruct(acc::to<std::string>("http://host/", i % 10,
+                                                  "/", i),
+                             {uint64_t(i)});
+  }
+  builder.buildHash([&](FBB*) { return obuilder.create().Union(); });
+
+  OrderedIndexS index = builder.toIndex();
+  EXPECT_EQ(fbs::HMap::OMapS, index.getHashType());
+  EXPECT_EQ("{ os:test }", index.toDebugString());
+  EXPECT_EQ(uint64_t(17), index.find("http://host/7/17")->indexes()->Get(0));
+  EXPECT_TRUE(index.find("http://host/7/18") == index.end());
+
+  auto range = prefixRange(index, "http://host/3/");
+  size_t n = 0;
+  for (auto it = range.first; it != range.second; ++it, n++) {
+    EXPECT_EQ(uint64_t(3), it->indexes()->Get(0) % 10);
+  }
+  EXPECT_EQ(size_t(100), n);
+  range = index.range("http://host/3/", "http://host/3/5");
+  EXPECT_EQ(uint32_t(45), range.second.rank() - range.first.rank());
+  EXPECT_TRUE(index.upper_bound("http://host/9/999") == index.end());
+  EXPECT_EQ("http://host/0/0", index.lower_bound("")->key()->str());
+}
+
+TEST(Index, filter) {
+  std::vector<fbs::HSlot64T> entries;
+  for (uint64_t i = 0; i < 1000; i++) {
+    entries.push_back(makeEntry(i * 2, i));
+  }
+  FBB fbb;
+  Index64Builder builder(&fbb);
+  HashMap64Builder hbuilder(0, &fbb);
+  hbuilder.build(std::move(entries));
+  builder.setFilter(hbuilder.buildFilter());
+  builder.buildHash([&](FBB*) { return hbuilder.create().Union(); });
+  Index64 index(builder.toIndex());
+  EXPECT_TRUE(index.hasFilter());
+  EXPECT_EQ("{ 8: }", index.toDebugString());
+
+  size_t passed = 0;
+  for (uint64_t i = 0; i < 1000; i++) {
+    EXPECT_TRUE(index.mayContain(i * 2));
+    EXPECT_EQ(i, index.find(i * 2)->indexes()->Get(0));
+    EXPECT_TRUE(index.find(i * 2 + 1) == index.end());
+    passed += index.mayContain(i * 2 + 1);
+  }
+  EXPECT_LT(passed, size_t(50));
+
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 100; i++) {
+    keys.push_back(i);
+  }
+  std::vector<Index64::const_iterator> out(keys.size());
+  index.findBatch(keys.data(), keys.size(), out.data());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_TRUE(out[i] == index.find(keys[i]));
+  }
+}
+
+TEST(Index, hashType) {
+  FBB fbb;
+  PerfectIndex64Builder builder(&fbb);
+  builder.setName("test");
+  PerfectHashMap64Builder hbuilder(100, &fbb);
+  for (uint64_t i = 0; i < 100; i++) {
+    hbuilder.findOrConstruct(i, {i});
+  }
+  builder.buildHash([&](FBB*) { return hbuilder.create().Union(); });
+  builder.finish();
+  auto data = builder.detachedData();
+
+  // a perfect hash index is read with PerfectIndex64, not Index64
+  PerfectIndex64 index(data.data());
+  EXPECT_EQ("{ p8:test }", index.toDebugString());
+  EXPECT_EQ(uint64_t(7), index.find(7)->indexes()->Get(0));
+  EXPECT_THROW(Index64 chained(data.data()), std::invalid_argument);
+}
+
+TEST(Index, merge) {
+  std::vector<fbs::HSlot64T> lentries;
+  std::vector<fbs::HSlot64T> rentries;
+  for (uint64_t i = 0; i < 1000; i++) {
+    lentries.push_back(makeEntry(i, i));
+    rentries.push_back(makeEntry(i + 500, i + 10500));
+  }
+  auto left = makeIndex(std::move(lentries));
+  auto right = makeIndex(std::move(rentries));
+
+  for (size_t threads : {1, 4}) {
+    auto keepLeft = makeIndex(
+        merge(*left, *right, MergePolicy::KeepLeft, threads));
+    auto keepRight = makeIndex(
+        merge(*left, *right, MergePolicy::KeepRight, threads));
+    auto both = makeIndex(
+        merge(*left, *right, MergePolicy::UnionIndexes, threads));
+    EXPECT_EQ(size_t(1500), keepLeft->scanSize());
+    EXPECT_EQ(size_t(1500), both->scanSize());
+    for (uint64_t i = 0; i < 1500; i++) {
+      auto l = keepLeft->find(i);
+      auto r = keepRight->find(i);
+      auto u = both->find(i);
+      ASSERT_TRUE(l != keepLeft->end() && r != keepRight->end());
+      ASSERT_TRUE(u != both->end());
+      uint64_t li = i < 1000 ? i : i + 10000;
+      uint64_t ri = i < 500 ? i : i + 10000;
+      EXPECT_EQ(li, l->indexes()->Get(0));
+      EXPECT_EQ(ri, r->indexes()->Get(0));
+      EXPECT_EQ(li, u->indexes()->Get(0));
+      EXPECT_EQ(li != ri ? 2u : 1u, u->indexes()->size());
+    }
+  }
+
+  auto shards = mergeShards(*left, *right, MergePolicy::KeepLeft, 2, 2);
+  ASSERT_EQ(size_t(4), shards.size());
+  for (size_t s = 0; s < shards.size(); s++) {
+    for (auto& entry : shards[s]) {
+      EXPECT_EQ(s, hashToShard(hashKey(entry.key), 2));
+    }
+  }
+}
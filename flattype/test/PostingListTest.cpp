@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "flattype/hash/PostingList.h"
+
+using namespace ftt;
+
+namespace {
+
+std::vector<BIndex> makeIndexes(uint16_t blocks, uint32_t n, uint32_t step) {
+  std::vector<BIndex> indexes;
+  for (uint16_t b = 0; b < blocks; b++) {
+    for (uint32_t i = 0; i < n; i++) {
+      indexes.push_back(BIndex{b, 0, i * step + b});
+    }
+  }
+  return indexes;
+}
+
+} // namespace
+
+TEST(PostingList, encode) {
+  auto indexes = makeIndexes(3, 1000, 7);
+  indexes.push_back(BIndex{1, 0, 8});
+  indexes.push_back(BIndex{2, 0, 0xfffffff0});
+  std::vector<uint32_t> data = encodePostings(indexes);
+  PostingList list(data.data());
+  EXPECT_EQ(size_t(3001), list.size());
+  EXPECT_EQ(size_t(3), list.groupCount());
+
+  std::vector<BIndex> decoded;
+  for (auto it = list.cbegin(); it != list.cend(); ++it) {
+    decoded.push_back(*it);
+  }
+  ASSERT_EQ(size_t(3001), decoded.size());
+  EXPECT_EQ(uint16_t(0), decoded[0].block);
+  EXPECT_EQ(uint32_t(0), decoded[0].index);
+  EXPECT_EQ(uint16_t(2), decoded.back().block);
+  EXPECT_EQ(uint32_t(0xfffffff0), decoded.back().index);
+
+  EXPECT_TRUE(list.contains(1, 8));
+  EXPECT_TRUE(list.contains(2, 6995));
+  EXPECT_FALSE(list.contains(2, 6996));
+  EXPECT_FALSE(list.contains(3, 0));
+}
+
+TEST(PostingList, contains) {
+  // a group of 79 chunks, probed at every chunk boundary
+  std::vector<uint32_t> data = encodePostings(makeIndexes(2, 10000, 3));
+  PostingList list(data.data());
+  for (uint32_t i = 0; i < 10000; i++) {
+    EXPECT_TRUE(list.contains(1, i * 3 + 1));
+    EXPECT_FALSE(list.contains(1, i * 3 + 2));
+  }
+  EXPECT_FALSE(list.contains(1, 0));
+  EXPECT_FALSE(list.contains(1, 30001));
+  EXPECT_TRUE(list.contains(0, 29997));
+}
+
+TEST(PostingList, intersect) {
+  uint32_t a[] = {1, 3, 5, 7, 9, 11, 13, 15, 17, 19};
+  uint32_t b[] = {0, 3, 6, 9, 12, 15, 18, 21};
+  uint32_t out[10];
+  EXPECT_EQ(size_t(3), intersectSorted(a, 10, b, 8, out));
+  EXPECT_EQ(uint32_t(15), out[2]);
+  uint32_t all[18];
+  EXPECT_EQ(size_t(15), uniteSorted(a, 10, b, 8, all));
+
+  auto d1 = encodePostings(makeIndexes(4, 10000, 2));
+  auto d2 = encodePostings(makeIndexes(2, 5000, 3));
+  auto d3 = encodePostings({BIndex{0, 0, 6}, BIndex{0, 0, 7},
+                            BIndex{1, 0, 7}, BIndex{1, 0, 13}});
+  std::vector<PostingList> lists = {
+    PostingList(d1.data()), PostingList(d2.data())};
+  auto both = intersectPostings(lists);
+  // blocks 0 and 1, i * 2 + b == j * 3 + b for j < 5000
+  EXPECT_EQ(size_t(5000), both.size());
+  for (auto& bi : both) {
+    EXPECT_EQ(uint32_t(0), (bi.index - bi.block) % 6);
+  }
+  lists.push_back(PostingList(d3.data()));
+  auto three = intersectPostings(lists);
+  ASSERT_EQ(size_t(3), three.size());
+  EXPECT_EQ(uint32_t(6), three[0].index);
+  EXPECT_EQ(uint16_t(1), three[1].block);
+  EXPECT_EQ(uint32_t(7), three[1].index);
+  EXPECT_EQ(uint32_t(13), three[2].index);
+
+  auto any = unitePostings(lists);
+  EXPECT_EQ(size_t(40000 + 5000 + 1), any.size());
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "flattype/TupleBuilder.h"
+#include "flattype/matrix/ColumnarMatrixBuilder.h"
+#include "flattype/matrix/MatrixBuilder.h"
+
+using namespace ftt;
+
+TEST(Ref, tuple) {
+  TupleBuilder builder;
+  builder.setValue(int32_t(1), std::string("abc"), 0.5);
+  Tuple tuple = builder.toTuple();
+  TupleRef ref = tuple.ref();
+  EXPECT_TRUE(ref.get() == tuple.get());
+  EXPECT_EQ(tuple.getCount(), ref.getCount());
+  for (size_t i = 0; i < tuple.getCount(); i++) {
+    EXPECT_TRUE(ref.getItem(i) == tuple.getItem(i));
+    EXPECT_TRUE(ref.getItemType(i) == tuple.getItemType(i));
+  }
+  int32_t a1, a2;
+  std::string b1, b2;
+  double c1, c2;
+  EXPECT_TRUE(tuple.getValue(a1, b1, c1));
+  EXPECT_TRUE(ref.getValue(a2, b2, c2));
+  EXPECT_EQ(a1, a2);
+  EXPECT_EQ(b1, b2);
+  EXPECT_EQ(c1, c2);
+  EXPECT_EQ(tuple.toDebugString(), ref.toDebugString());
+  EXPECT_FALSE(bool(TupleRef()));
+}
+
+TEST(Ref, matrix) {
+  MatrixBuilder builder;
+  builder.setRowValue(0, int32_t(1), std::string("a"));
+  builder.setRowValue(1, int32_t(2), std::string("b"));
+  Matrix matrix = builder.toMatrix();
+  MatrixRef ref = matrix.ref();
+  EXPECT_EQ(matrix.getRowCount(), ref.getRowCount());
+  EXPECT_EQ(matrix.getColCount(), ref.getColCount());
+  for (size_t i = 0; i < matrix.getRowCount(); i++) {
+    RecordRef row = ref.getRow(i);
+    EXPECT_TRUE(row.get() == matrix.getRow(i));
+    EXPECT_EQ(matrix.getColCount(), row.getCount());
+    int32_t a1, a2, a3;
+    std::string b1, b2, b3;
+    EXPECT_TRUE(matrix.getRowValue(i, a1, b1));
+    EXPECT_TRUE(ref.getRowValue(i, a2, b2));
+    EXPECT_TRUE(row.getValue(a3, b3));
+    EXPECT_EQ(a1, a2);
+    EXPECT_EQ(a1, a3);
+    EXPECT_EQ(b1, b2);
+    EXPECT_EQ(b1, b3);
+  }
+  EXPECT_EQ(matrix.toDebugString(), ref.toDebugString());
+}
+
+TEST(Ref, columnarMatrix) {
+  ColumnarMatrixBuilder builder;
+  builder.setRowValue(0, int32_t(1), std::string("a"));
+  builder.setRowValue(1, int32_t(2), std::string("b"));
+  ColumnarMatrix matrix = builder.toColumnarMatrix();
+  ColumnarMatrixRef ref = matrix.ref();
+  EXPECT_EQ(matrix.getRowCount(), ref.getRowCount());
+  EXPECT_EQ(matrix.getColCount(), ref.getColCount());
+  for (size_t j = 0; j < matrix.getColCount(); j++) {
+    EXPECT_TRUE(ref.getCol(j) == matrix.getCol(j));
+  }
+  for (size_t i = 0; i < matrix.getRowCount(); i++) {
+    int32_t a1, a2;
+    std::string b1, b2;
+    EXPECT_TRUE(matrix.getRowValue(i, a1, b1));
+    EXPECT_TRUE(ref.getRowValue(i, a2, b2));
+    EXPECT_EQ(a1, a2);
+    EXPECT_EQ(b1, b2);
+  }
+  EXPECT_EQ(matrix.toDebugString(), ref.toDebugString());
+}
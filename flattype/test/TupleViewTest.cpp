@@ -0,0 +1,49 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "flattype/Serialize.h"
+#include "flattype/Tuple.h"
+
+using namespace ftt;
+
+TEST(TupleView, get) {
+  std::vector<float> f = {1.0, 2.0, 3.0};
+  std::pair<int32_t, int32_t> p = std::make_pair(1, 2);
+  auto buf = serializeVariant(int32_t(10), std::string("abc"), f, p);
+  Tuple tuple(buf.data());
+
+  auto view = tuple.getView<int32_t, std::string, std::vector<float>,
+                            std::pair<int32_t, int32_t>>();
+  ASSERT_TRUE(bool(view));
+  EXPECT_EQ(10, view.get<0>());
+  EXPECT_EQ("abc", view.get<1>().str());
+  EXPECT_EQ(f, std::vector<float>(view.get<2>().begin(), view.get<2>().end()));
+  std::pair<int32_t, int32_t> q;
+  decode(view.get<3>(), q);
+  EXPECT_EQ(p, q);
+}
+
+TEST(TupleView, check) {
+  auto buf = serializeVariant(int32_t(10), std::string("abc"));
+  Tuple tuple(buf.data());
+
+  EXPECT_TRUE(bool(tuple.getView<int32_t, acc::StringPiece>()));
+  EXPECT_FALSE(bool(tuple.getView<int64_t, acc::StringPiece>()));
+  EXPECT_FALSE(bool(tuple.getView<int32_t>()));
+  EXPECT_FALSE(bool(tuple.getView<int32_t, acc::StringPiece, int32_t>()));
+  EXPECT_FALSE(TupleView<int32_t>::check(nullptr));
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2018 Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include "flattype/Encoding.h"
+#include "flattype/matrix/ColumnarMatrixBuilder.h"
+#include "flattype/matrix/MatrixBuilder.h"
+#include "flattype/matrix/VectorSearch.h"
+
+using namespace ftt;
+
+namespace {
+
+const size_t kRows = 200;
+const size_t kDim = 37;   // not a multiple of any vector width
+
+std::vector<float> randomVector(uint32_t& seed, size_t dim) {
+  std::vector<float> v(dim);
+  for (auto& x : v) {
+    seed = seed * 1103515245 + 12345;
+    x = float((seed >> 8) & 0xffff) / 0x8000 - 1.0f;
+  }
+  return v;
+}
+
+std::vector<std::vector<float>> randomRows(size_t rows, size_t dim) {
+  uint32_t seed = 1;
+  std::vector<std::vector<float>> out;
+  for (size_t i = 0; i < rows; i++) {
+    out.push_back(randomVector(seed, dim));
+  }
+  return out;
+}
+
+float referenceDistance(Metric metric,
+                        const std::vector<float>& q,
+                        const std::vector<float>& v) {
+  double dot = 0, l2 = 0, qq = 0, vv = 0;
+  for (size_t i = 0; i < q.size(); i++) {
+    dot += q[i] * v[i];
+    l2 += (q[i] - v[i]) * (q[i] - v[i]);
+    qq += q[i] * q[i];
+    vv += v[i] * v[i];
+  }
+  switch (metric) {
+    case Metric::DotProduct:
+      return float(-dot);
+    case Metric::L2:
+      return float(l2);
+    case Metric::Cosine:
+      return float(1 - dot / (std::sqrt(qq) * std::sqrt(vv)));
+  }
+  return 0;
+}
+
+// check actual against a scalar brute force, rows of another dimension
+// are skipped; rows at equal distances may come in either order
+void expectKnn(const std::vector<std::vector<float>>& rows,
+               const std::vector<float>& q,
+               Metric metric,
+               size_t k,
+               const std::vector<Neighbor>& actual) {
+  std::vector<float> expected;
+  for (auto& row : rows) {
+    if (row.size() == q.size()) {
+      expected.push_back(referenceDistance(metric, q, row));
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+  expected.resize(std::min(k, expected.size()));
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_NEAR(expected[i], actual[i].distance, 1e-4);
+    ASSERT_LT(actual[i].row, rows.size());
+    EXPECT_NEAR(referenceDistance(metric, q, rows[actual[i].row]),
+                actual[i].distance, 1e-4);
+  }
+}
+
+const Metric kMetrics[] = {Metric::DotProduct, Metric::L2, Metric::Cosine};
+
+} // namespace
+
+TEST(VectorSearch, kernelName) {
+  std::string name = vectorKernelName();
+  EXPECT_TRUE(name == "avx512" || name == "avx2" || name == "scalar");
+}
+
+TEST(VectorSearch, distance) {
+  auto rows = randomRows(2, kDim);
+  // 64-byte aligned copies, and copies one float off the alignment
+  alignas(64) float a[2 * kDim + 16];
+  alignas(64) float b[2 * kDim + 16];
+  for (size_t off : {0, 1}) {
+    memcpy(a + off, rows[0].data(), kDim * sizeof(float));
+    memcpy(b + off, rows[1].data(), kDim * sizeof(float));
+    for (auto metric : kMetrics) {
+      EXPECT_NEAR(referenceDistance(metric, rows[0], rows[1]),
+                  vectorDistance(metric, a + off, b + off, kDim), 1e-4);
+    }
+  }
+}
+
+TEST(VectorSearch, matrix) {
+  auto rows = randomRows(kRows, kDim);
+  rows[7].resize(kDim - 1);
+  uint32_t seed = 99;
+  auto query = randomVector(seed, kDim);
+
+  MatrixBuilder mbuilder;
+  mbuilder.setVectorAlignment(64);
+  ColumnarMatrixBuilder cbuilder;
+  for (size_t i = 0; i < kRows; i++) {
+    mbuilder.setRowValue(i, int32_t(i), rows[i]);
+    cbuilder.setRowValue(i, int32_t(i), rows[i]);
+  }
+  mbuilder.finish();
+  cbuilder.finish();
+  Matrix matrix(mbuilder.data());
+  ColumnarMatrix columnar(cbuilder.data());
+
+  for (auto metric : kMetrics) {
+    for (size_t threads : {1, 3}) {
+      KnnOptions options;
+      options.metric = metric;
+      options.k = 10;
+      options.threads = threads;
+      expectKnn(rows, query, metric, options.k,
+                knnSearch(matrix, 1, query, options));
+      expectKnn(rows, query, metric, options.k,
+                knnSearch(columnar, 1, query, options));
+      // column 0 holds no vectors
+      EXPECT_TRUE(knnSearch(matrix, 0, query, options).empty());
+      EXPECT_TRUE(knnSearch(columnar, 0, query, options).empty());
+    }
+  }
+}
+
+TEST(VectorSearch, block) {
+  auto rows = randomRows(kRows, kDim);
+  std::vector<float> data;
+  for (auto& row : rows) {
+    data.insert(data.end(), row.begin(), row.end());
+  }
+  uint32_t seed = 7;
+  auto query = randomVector(seed, kDim);
+
+  ::flatbuffers::FlatBufferBuilder fbb;
+  fbb.Finish(encodeAligned(fbb, data, 64));
+  auto block = ::flatbuffers::GetRoot<fbs::FloatArray>(fbb.GetBufferPointer());
+
+  for (auto metric : kMetrics) {
+    KnnOptions options;
+    options.metric = metric;
+    options.k = 5;
+    expectKnn(rows, query, metric, options.k,
+              knnSearch(data.data(), kRows, query.data(), kDim, options));
+    expectKnn(rows, query, metric, options.k,
+              knnSearch(block, query, options));
+  }
+
+  // no block, a block without a value and an empty block find nothing
+  KnnOptions options;
+  EXPECT_TRUE(knnSearch(nullptr, query, options).empty());
+  ::flatbuffers::FlatBufferBuilder nfbb;
+  nfbb.Finish(fbs::CreateFloatArray(nfbb));
+  EXPECT_TRUE(knnSearch(
+      ::flatbuffers::GetRoot<fbs::FloatArray>(nfbb.GetBufferPointer()),
+      query, options).empty());
+  ::flatbuffers::FlatBufferBuilder efbb;
+  efbb.Finish(encodeAligned(efbb, std::vector<float>(), 64));
+  EXPECT_TRUE(knnSearch(
+      ::flatbuffers::GetRoot<fbs::FloatArray>(efbb.GetBufferPointer()),
+      query, options).empty());
+}
+
+TEST(VectorSearch, bounds) {
+  auto rows = randomRows(5, kDim);
+  MatrixBuilder builder;
+  for (size_t i = 0; i < rows.size(); i++) {
+    builder.setItemValue(i, 0, rows[i]);
+  }
+  builder.finish();
+  Matrix matrix(builder.data());
+  uint32_t seed = 3;
+  auto query = randomVector(seed, kDim);
+
+  // k > rows: every row, sorted
+  KnnOptions options;
+  options.k = 100;
+  options.threads = 8;
+  expectKnn(rows, query, options.metric, options.k,
+            knnSearch(matrix, 0, query, options));
+  // a query of another dimension matches no row
+  query.resize(kDim + 1);
+  EXPECT_TRUE(knnSearch(matrix, 0, query, options).empty());
+  // k = 0
+  query.resize(kDim);
+  options.k = 0;
+  EXPECT_TRUE(knnSearch(matrix, 0, query, options).empty());
+}
+
+TEST(VectorSearch, emptyRecord) {
+  auto rows = randomRows(2, kDim);
+  ::flatbuffers::FlatBufferBuilder fbb;
+  std::vector<::flatbuffers::Offset<fbs::Record>> records;
+  for (auto& row : rows) {
+    std::vector<::flatbuffers::Offset<fbs::Item>> items;
+    items.push_back(fbs::CreateItem(fbb, fbs::Any::FloatArray,
+                                    encode(fbb, row).Union()));
+    records.push_back(fbs::CreateRecordDirect(fbb, &items));
+  }
+  // a record without its value vector
+  records.push_back(fbs::CreateRecord(fbb));
+  fbb.Finish(fbs::CreateMatrixDirect(fbb, &records));
+  auto matrix = ::flatbuffers::GetRoot<fbs::Matrix>(fbb.GetBufferPointer());
+
+  KnnOptions options;
+  auto found = knnSearch(matrix, false, 0, rows[0].data(), kDim, options);
+  ASSERT_EQ(size_t(2), found.size());
+  EXPECT_EQ(size_t(0), found[0].row);
+  // read as columns, record 2 is an empty column
+  EXPECT_TRUE(knnSearch(matrix, true, 2, rows[0].data(), kDim,
+                        options).empty());
+}